@@ -29,8 +29,17 @@ function doMdns()
     avahi-publish-service rock-and-roll-gw _magellan._tcp 8081 "id={d7107580-952d-4fd4-a4c2-a01f4067fd39}" "cv=234"
 }
 
+function doMdnsNative()
+{
+    echo "Advertising using the built-in MDNS responder"
+
+    node mdr.js rock-and-roll-gw 8081 "{d7107580-952d-4fd4-a4c2-a01f4067fd39}" 234
+}
+
 if [[ "${1}" == "-mdns" ]]; then
     doMdns
+elif [[ "${1}" == "-mdns-native" ]]; then
+    doMdnsNative
 elif [[ "${1}" == "-ssdp" ]]; then
     doSsdp
 fi
\ No newline at end of file
@@ -0,0 +1,224 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+// Magellan mDNS Responder (mdr) - a minimal DNS-SD responder that advertises the REST simulator
+// without needing avahi-daemon.  Useful for exercising the library's native mDNS engine over loopback.
+//
+// usage: node mdr.js [instanceName] [port] [id] [cv] [address]
+
+const dgram = require('dgram');
+const os = require('os');
+
+console.log('---------------------------------------------------------------------------');
+console.log('Magellan mDNS Responder (mdr) version 0.1');
+console.log('');
+console.log('Copyright (c) 2020 Rally Tactical Systems, Inc.');
+console.log('---------------------------------------------------------------------------');
+
+const MDNS_GROUP = '224.0.0.251';
+const MDNS_PORT = 5353;
+
+const TYPE_A = 1;
+const TYPE_PTR = 12;
+const TYPE_TXT = 16;
+const TYPE_SRV = 33;
+const TYPE_ANY = 255;
+
+var instanceName = process.argv[2] || 'rock-and-roll-gw';
+var port = parseInt(process.argv[3] || '8081');
+var id = process.argv[4] || '{d7107580-952d-4fd4-a4c2-a01f4067fd39}';
+var cv = process.argv[5] || '234';
+var address = process.argv[6] || firstAddress();
+
+var serviceName = '_magellan._tcp.local';
+var instanceFqdn = instanceName + '.' + serviceName;
+var hostName = os.hostname().split('.')[0] + '.local';
+
+// Per RFC 6762 recommendations - shared records 75 minutes, unique records 2 minutes
+var PTR_TTL = 4500;
+var HOST_TTL = 120;
+
+function firstAddress() {
+	var ifs = os.networkInterfaces();
+	for(var name in ifs) {
+		for(var x = 0; x < ifs[name].length; x++) {
+			var a = ifs[name][x];
+			if(a.family == 'IPv4' && !a.internal) {
+				return a.address;
+			}
+		}
+	}
+	return '127.0.0.1';
+}
+
+function encodeName(name) {
+	var parts = name.split('.');
+	var bufs = [];
+	for(var x = 0; x < parts.length; x++) {
+		if(parts[x].length == 0) {
+			continue;
+		}
+		var label = Buffer.from(parts[x]);
+		bufs.push(Buffer.from([label.length]));
+		bufs.push(label);
+	}
+	bufs.push(Buffer.from([0]));
+	return Buffer.concat(bufs);
+}
+
+function readName(buf, pos) {
+	var labels = [];
+	var jumped = false;
+	var end = pos;
+	var jumps = 0;
+	while(pos < buf.length) {
+		var l = buf[pos];
+		if((l & 0xc0) == 0xc0) {
+			if(!jumped) {
+				end = pos + 2;
+			}
+			jumped = true;
+			pos = ((l & 0x3f) << 8) | buf[pos + 1];
+			if(++jumps > 32) {
+				break;
+			}
+			continue;
+		}
+		pos++;
+		if(l == 0) {
+			break;
+		}
+		labels.push(buf.toString('utf8', pos, pos + l));
+		pos += l;
+	}
+	return { name: labels.join('.'), end: (jumped ? end : pos) };
+}
+
+function record(name, type, klass, ttl, rdata) {
+	var hdr = Buffer.alloc(10);
+	hdr.writeUInt16BE(type, 0);
+	hdr.writeUInt16BE(klass, 2);
+	hdr.writeUInt32BE(ttl, 4);
+	hdr.writeUInt16BE(rdata.length, 8);
+	return Buffer.concat([encodeName(name), hdr, rdata]);
+}
+
+function ptrRecord(ttl) {
+	return record(serviceName, TYPE_PTR, 1, ttl, encodeName(instanceFqdn));
+}
+
+function srvRecord(ttl) {
+	var fixed = Buffer.alloc(6);
+	fixed.writeUInt16BE(0, 0);
+	fixed.writeUInt16BE(0, 2);
+	fixed.writeUInt16BE(port, 4);
+	return record(instanceFqdn, TYPE_SRV, 0x8001, ttl, Buffer.concat([fixed, encodeName(hostName)]));
+}
+
+function txtRecord(ttl) {
+	var items = ['id=' + id, 'cv=' + cv];
+	var bufs = [];
+	for(var x = 0; x < items.length; x++) {
+		var b = Buffer.from(items[x]);
+		bufs.push(Buffer.from([b.length]));
+		bufs.push(b);
+	}
+	return record(instanceFqdn, TYPE_TXT, 0x8001, ttl, Buffer.concat(bufs));
+}
+
+function aRecord(ttl) {
+	return record(hostName, TYPE_A, 0x8001, ttl, Buffer.from(address.split('.').map(function(v) { return parseInt(v); })));
+}
+
+function response(ttlScale) {
+	var hdr = Buffer.alloc(12);
+	hdr.writeUInt16BE(0, 0);
+	hdr.writeUInt16BE(0x8400, 2);
+	hdr.writeUInt16BE(0, 4);
+	hdr.writeUInt16BE(1, 6);
+	hdr.writeUInt16BE(0, 8);
+	hdr.writeUInt16BE(3, 10);
+	return Buffer.concat([hdr,
+						  ptrRecord(PTR_TTL * ttlScale),
+						  srvRecord(HOST_TTL * ttlScale),
+						  txtRecord(HOST_TTL * ttlScale),
+						  aRecord(HOST_TTL * ttlScale)]);
+}
+
+var sock = dgram.createSocket({ type: 'udp4', reuseAddr: true });
+
+function send(buf) {
+	sock.send(buf, 0, buf.length, MDNS_PORT, MDNS_GROUP);
+}
+
+sock.on('message', function(msg, rinfo) {
+	if(msg.length < 12) {
+		return;
+	}
+
+	var flags = msg.readUInt16BE(2);
+	if((flags & 0x8000) != 0) {
+		return;
+	}
+
+	var qd = msg.readUInt16BE(4);
+	var an = msg.readUInt16BE(6);
+	var pos = 12;
+	var wanted = false;
+
+	for(var x = 0; x < qd; x++) {
+		var n = readName(msg, pos);
+		var qtype = msg.readUInt16BE(n.end);
+		pos = n.end + 4;
+		var lname = n.name.toLowerCase();
+		if((lname == serviceName && (qtype == TYPE_PTR || qtype == TYPE_ANY)) ||
+		   lname == instanceFqdn.toLowerCase() ||
+		   lname == hostName.toLowerCase()) {
+			wanted = true;
+		}
+	}
+
+	if(!wanted) {
+		return;
+	}
+
+	// Known-answer suppression - stay quiet if the querier already holds our PTR with at least half its TTL
+	for(var x = 0; x < an; x++) {
+		var n = readName(msg, pos);
+		var type = msg.readUInt16BE(n.end);
+		var ttl = msg.readUInt32BE(n.end + 4);
+		var rdlen = msg.readUInt16BE(n.end + 8);
+		if(type == TYPE_PTR && n.name.toLowerCase() == serviceName) {
+			var target = readName(msg, n.end + 10);
+			if(target.name.toLowerCase() == instanceFqdn.toLowerCase() && ttl * 2 >= PTR_TTL) {
+				console.log('query from ' + rinfo.address + ' - suppressed by known answer');
+				return;
+			}
+		}
+		pos = n.end + 10 + rdlen;
+	}
+
+	console.log('query from ' + rinfo.address + ' - responding');
+	send(response(1));
+});
+
+sock.bind(MDNS_PORT, function() {
+	sock.addMembership(MDNS_GROUP);
+	sock.setMulticastTTL(255);
+	sock.setMulticastLoopback(true);
+
+	console.log('Advertising ' + instanceFqdn + ' at ' + address + ':' + port + ' (id=' + id + ', cv=' + cv + '). Press Ctrl-C to stop.');
+
+	// Announce twice, one second apart (RFC 6762 8.3)
+	send(response(1));
+	setTimeout(function() { send(response(1)); }, 1000);
+});
+
+// Send a goodbye on the way out so queriers drop us immediately
+process.on('SIGINT', function() {
+	console.log('sending goodbye');
+	send(response(0));
+	setTimeout(function() { process.exit(0); }, 250);
+});
@@ -5,6 +5,7 @@
 
 const https = require('https');
 const fs = require('fs');
+const zlib = require('zlib');
 const { exit } = require('process');
 
 console.log('---------------------------------------------------------------------------');
@@ -15,11 +16,111 @@ console.log('-------------------------------------------------------------------
 
 var port = 8081;
 
+// Pass -nocbor to behave like a device that only speaks JSON
+var allowCbor = (process.argv.indexOf('-nocbor') < 0);
+
+// Pass -nocompress to never compress responses
+var allowCompression = (process.argv.indexOf('-nocompress') < 0);
+
 console.log('Listening on port ' + port + '. Press Ctrl-C to stop.');
 
 // This is the JSON content to be returned for REST "/config" requests
 var configContent = fs.readFileSync('./config.json');
 
+// Minimal CBOR (RFC 7049) encoder - just enough for JSON-shaped data
+function cborHead(major, n) {
+	if(n < 24) {
+		return Buffer.from([(major << 5) | n]);
+	}
+	else if(n < 0x100) {
+		return Buffer.from([(major << 5) | 24, n]);
+	}
+	else if(n < 0x10000) {
+		var b = Buffer.alloc(3);
+		b[0] = (major << 5) | 25;
+		b.writeUInt16BE(n, 1);
+		return b;
+	}
+	else if(n < 0x100000000) {
+		var b = Buffer.alloc(5);
+		b[0] = (major << 5) | 26;
+		b.writeUInt32BE(n, 1);
+		return b;
+	}
+	else {
+		var b = Buffer.alloc(9);
+		b[0] = (major << 5) | 27;
+		b.writeUInt32BE(Math.floor(n / 0x100000000), 1);
+		b.writeUInt32BE(n % 0x100000000, 5);
+		return b;
+	}
+}
+
+function toCbor(v) {
+	if(v === null || v === undefined) {
+		return Buffer.from([0xf6]);
+	}
+	else if(v === true) {
+		return Buffer.from([0xf5]);
+	}
+	else if(v === false) {
+		return Buffer.from([0xf4]);
+	}
+	else if(typeof v === 'number') {
+		if(Number.isInteger(v) && Math.abs(v) <= Number.MAX_SAFE_INTEGER) {
+			return (v >= 0 ? cborHead(0, v) : cborHead(1, -1 - v));
+		}
+		var b = Buffer.alloc(9);
+		b[0] = 0xfb;
+		b.writeDoubleBE(v, 1);
+		return b;
+	}
+	else if(typeof v === 'string') {
+		var s = Buffer.from(v, 'utf8');
+		return Buffer.concat([cborHead(3, s.length), s]);
+	}
+	else if(Array.isArray(v)) {
+		return Buffer.concat([cborHead(4, v.length)].concat(v.map(toCbor)));
+	}
+	else {
+		var keys = Object.keys(v);
+		var parts = [cborHead(5, keys.length)];
+		keys.forEach(function(k) {
+			parts.push(toCbor(k));
+			parts.push(toCbor(v[k]));
+		});
+		return Buffer.concat(parts);
+	}
+}
+
+var cborContent = toCbor(JSON.parse(configContent));
+
+console.log('Configuration is ' + configContent.length + ' bytes as JSON, ' + cborContent.length + ' bytes as CBOR' + (allowCbor ? '' : ' (CBOR disabled)'));
+
+// Compresses the body with the first encoding from the client's Accept-Encoding that we support
+function compress(body, acceptEncoding) {
+	if(allowCompression && acceptEncoding != undefined) {
+		var offered = acceptEncoding.split(',').map(function(e) { return e.trim().split(';')[0]; });
+
+		for(var x = 0; x < offered.length; x++) {
+			if(offered[x] == 'zstd' && zlib.zstdCompressSync != undefined) {
+				return { encoding: 'zstd', body: zlib.zstdCompressSync(body) };
+			}
+			else if(offered[x] == 'br' && zlib.brotliCompressSync != undefined) {
+				return { encoding: 'br', body: zlib.brotliCompressSync(body) };
+			}
+			else if(offered[x] == 'gzip') {
+				return { encoding: 'gzip', body: zlib.gzipSync(body) };
+			}
+			else if(offered[x] == 'deflate') {
+				return { encoding: 'deflate', body: zlib.deflateSync(body) };
+			}
+		}
+	}
+
+	return { encoding: undefined, body: body };
+}
+
 // Our web server will provide this cert to authenticate itself to the client
 const options = {
 	cert: fs.readFileSync('../certs/server.crt'),
@@ -72,8 +173,29 @@ https.createServer(options, function (req, res) {
 	}
 
 	if(retval == 200) {
-		res.writeHead(retval, {'content-type': 'application/json'});
-		res.end(configContent);
+		// Content negotiation - CBOR if the client asks for it, JSON otherwise
+		var accept = req.headers['accept'];
+		var contentType = 'application/json';
+		var content = configContent;
+
+		if(allowCbor && accept != undefined && accept.indexOf('application/cbor') >= 0) {
+			contentType = 'application/cbor';
+			content = cborContent;
+		}
+
+		var headers = {'content-type': contentType};
+		var compressed = compress(content, req.headers['accept-encoding']);
+
+		if(compressed.encoding != undefined) {
+			headers['content-encoding'] = compressed.encoding;
+			console.log('   sending ' + content.length + ' bytes of ' + contentType + ' as ' + compressed.body.length + ' bytes of ' + compressed.encoding);
+		}
+		else {
+			console.log('   sending ' + content.length + ' bytes of ' + contentType);
+		}
+
+		res.writeHead(retval, headers);
+		res.end(compressed.body);
 	}
 	else {
 		res.writeHead(retval);		
@@ -0,0 +1,96 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include "ChangeJournal.hpp"
+
+namespace Magellan
+{
+    ChangeJournal::ChangeJournal()
+    {
+        _capacity = 4096;
+        _lastSeq = 0;
+    }
+
+    ChangeJournal::~ChangeJournal()
+    {
+    }
+
+    void ChangeJournal::setCapacity(size_t capacity)
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        _capacity = (capacity > 0 ? capacity : 1);
+        while(_entries.size() > _capacity)
+        {
+            _entries.pop_front();
+        }
+    }
+
+    void ChangeJournal::reset()
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        _entries.clear();
+        _lastSeq = 0;
+    }
+
+    uint64_t ChangeJournal::append(Operation_t op, const LazyTalkgroup::Ptr& tg)
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        Entry_t e;
+        e._seq = ++_lastSeq;
+        e._op = op;
+        e._id = tg->id();
+        e._deviceKey = tg->deviceKey();
+        if(op != opRemove)
+        {
+            e._tg = tg;
+        }
+
+        _entries.push_back(e);
+        if(_entries.size() > _capacity)
+        {
+            _entries.pop_front();
+        }
+
+        return e._seq;
+    }
+
+    uint64_t ChangeJournal::lastSequence()
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        return _lastSeq;
+    }
+
+    bool ChangeJournal::changesSince(uint64_t seq, EntryList_t& entries, uint64_t& lastSeq)
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        entries.clear();
+        lastSeq = _lastSeq;
+
+        if(seq > _lastSeq)
+        {
+            return false;
+        }
+
+        // Oldest sequence we can still account for
+        uint64_t firstSeq = (_entries.empty() ? (_lastSeq + 1) : _entries.front()._seq);
+        if(seq + 1 < firstSeq)
+        {
+            return false;
+        }
+
+        // Sequence numbers are contiguous so we can index straight to the first one wanted
+        for(size_t x = (size_t)(seq + 1 - firstSeq); x < _entries.size(); x++)
+        {
+            entries.push_back(_entries[x]);
+        }
+
+        return true;
+    }
+}
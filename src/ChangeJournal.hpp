@@ -0,0 +1,76 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef CHANGEJOURNAL_HPP
+#define CHANGEJOURNAL_HPP
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MagellanDataModel.hpp"
+#include "LazyTalkgroup.hpp"
+
+namespace Magellan
+{
+    /** @brief Bounded, sequence-numbered record of talkgroup changes used to let consumers catch up **/
+    class ChangeJournal
+    {
+    public:
+        typedef enum
+        {
+            opAdd,
+            opModify,
+            opRemove
+        } Operation_t;
+
+        /** @brief A journaled change **/
+        typedef struct _Entry_t
+        {
+            uint64_t                                        _seq;
+            Operation_t                                     _op;
+            std::string                                     _id;
+            std::string                                     _deviceKey;
+
+            /** @brief The talkgroup as it is after the change (empty for removals) **/
+            LazyTalkgroup::Ptr                              _tg;
+        } Entry_t;
+
+        typedef std::vector<Entry_t> EntryList_t;
+
+        ChangeJournal();
+        virtual ~ChangeJournal();
+
+        /** @brief Sets the maximum number of entries retained **/
+        void setCapacity(size_t capacity);
+
+        /** @brief Empties the journal and restarts sequencing **/
+        void reset();
+
+        /** @brief Records a change and returns its sequence number - the talkgroup is shared, not copied **/
+        uint64_t append(Operation_t op, const LazyTalkgroup::Ptr& tg);
+
+        /** @brief Sequence number of the most recent change (0 if none) **/
+        uint64_t lastSequence();
+
+        /** 
+         * @brief Retrieves the changes after seq
+         * 
+         * Returns false if the journal no longer holds everything after seq (it has rolled over or seq is from
+         * the future) in which case the caller needs to resynchronize from a full snapshot.
+         **/
+        bool changesSince(uint64_t seq, EntryList_t& entries, uint64_t& lastSeq);
+
+    private:
+        std::mutex              _lock;
+        std::deque<Entry_t>     _entries;
+        size_t                  _capacity;
+        uint64_t                _lastSeq;
+    };
+}
+
+#endif
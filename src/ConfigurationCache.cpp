@@ -0,0 +1,416 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include <string.h>
+
+#include "ConfigurationCache.hpp"
+#include "MagellanCore.hpp"
+
+namespace Magellan
+{
+    static const char *TAG = "ConfigurationCache";
+
+    const char      *ConfigurationCache::FILE_NAME = "magellan.cache";
+    const char      *ConfigurationCache::SIGNATURE = "MGLNCCH1";
+    const size_t    ConfigurationCache::SIGNATURE_SIZE = 8;
+    const uint32_t  ConfigurationCache::RECORD_MAGIC = 0x5243474d;
+    const uint32_t  ConfigurationCache::JSON_RECORD_MAGIC = 0x5243474a;
+
+    // magic, key length, URL length, body length, version, checksum
+    const size_t    ConfigurationCache::RECORD_HEADER_SIZE = (4 + 4 + 4 + 4 + 8 + 4);
+
+    ConfigurationCache::ConfigurationCache()
+    {
+        _fp = nullptr;
+    }
+
+    ConfigurationCache::~ConfigurationCache()
+    {
+        close();
+    }
+
+    bool ConfigurationCache::open(const std::string& directory)
+    {
+        close();
+
+        _fn = directory;
+        if(!_fn.empty() && _fn[_fn.size() - 1] != '/' && _fn[_fn.size() - 1] != '\\')
+        {
+            _fn.append("/");
+        }
+        _fn.append(FILE_NAME);
+
+        size_t liveBytes = 0;
+        size_t fileBytes = 0;
+        bool damaged = false;
+
+        if(!load(liveBytes, fileBytes, damaged) || damaged || ((fileBytes - SIGNATURE_SIZE - liveBytes) > liveBytes))
+        {
+            // Start afresh with just what's current
+            if(!rewrite())
+            {
+                Core::getLogger()->e(TAG, "cannot create %s", _fn.c_str());
+                _records.clear();
+                return false;
+            }
+        }
+
+        _fp = DataModel::_internalFileOpener(_fn.c_str(), "ab");
+        if(_fp == nullptr)
+        {
+            Core::getLogger()->e(TAG, "cannot open %s", _fn.c_str());
+            _records.clear();
+            return false;
+        }
+
+        Core::getLogger()->d(TAG, "opened %s - %zu device(s)", _fn.c_str(), _records.size());
+
+        return true;
+    }
+
+    void ConfigurationCache::close()
+    {
+        if(_fp != nullptr)
+        {
+            fclose(_fp);
+            _fp = nullptr;
+        }
+
+        _records.clear();
+    }
+
+    void ConfigurationCache::getEntries(EntryList_t& entries) const
+    {
+        entries.clear();
+
+        for(RecordMap_t::const_iterator itr = _records.begin();
+            itr != _records.end();
+            itr++)
+        {
+            Entry_t e;
+            e._deviceKey = itr->first;
+            e._url = itr->second._url;
+            e._version = (unsigned long)itr->second._version;
+            entries.push_back(e);
+        }
+    }
+
+    bool ConfigurationCache::find(const std::string& deviceKey, unsigned long version, DataModel::DeviceConfiguration& dc) const
+    {
+        RecordMap_t::const_iterator itr = _records.find(deviceKey);
+        if(itr == _records.end() || itr->second._version != version)
+        {
+            return false;
+        }
+
+        return find(deviceKey, dc);
+    }
+
+    bool ConfigurationCache::find(const std::string& deviceKey, DataModel::DeviceConfiguration& dc) const
+    {
+        RecordMap_t::const_iterator itr = _records.find(deviceKey);
+        if(itr == _records.end())
+        {
+            return false;
+        }
+
+        try
+        {
+            const std::vector<uint8_t>& body = itr->second._body;
+            dc = (itr->second._isCbor ? nlohmann::json::from_cbor(body) : nlohmann::json::parse(body.begin(), body.end()));
+        }
+        catch(...)
+        {
+            Core::getLogger()->e(TAG, "cannot decode cached configuration for %s", deviceKey.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ConfigurationCache::store(const std::string& deviceKey, const std::string& url, const DataModel::DeviceConfiguration& dc)
+    {
+        if(_fp == nullptr)
+        {
+            return false;
+        }
+
+        nlohmann::json j = dc;
+        std::vector<uint8_t> cbor = nlohmann::json::to_cbor(j);
+
+        return store(deviceKey, url, dc.version, cbor, true);
+    }
+
+    bool ConfigurationCache::store(const std::string& deviceKey, const std::string& url, unsigned long version, std::vector<uint8_t>& body, bool isCbor)
+    {
+        if(_fp == nullptr)
+        {
+            return false;
+        }
+
+        Record_t rec;
+        rec._url = url;
+        rec._version = version;
+        rec._isCbor = isCbor;
+        rec._body.swap(body);
+
+        RecordMap_t::iterator itr = _records.find(deviceKey);
+        if(itr != _records.end() &&
+           itr->second._version == rec._version &&
+           itr->second._url.compare(rec._url) == 0 &&
+           itr->second._isCbor == rec._isCbor &&
+           itr->second._body == rec._body)
+        {
+            return true;
+        }
+
+        if(!appendRecord(_fp, deviceKey, rec) || fflush(_fp) != 0)
+        {
+            Core::getLogger()->e(TAG, "cannot write to %s", _fn.c_str());
+            return false;
+        }
+
+        _records[deviceKey] = rec;
+
+        return true;
+    }
+
+    bool ConfigurationCache::remove(const std::string& deviceKey)
+    {
+        if(_fp == nullptr)
+        {
+            return false;
+        }
+
+        RecordMap_t::iterator itr = _records.find(deviceKey);
+        if(itr == _records.end())
+        {
+            return true;
+        }
+
+        Record_t tombstone;
+        tombstone._version = 0;
+        tombstone._isCbor = true;
+
+        if(!appendRecord(_fp, deviceKey, tombstone) || fflush(_fp) != 0)
+        {
+            Core::getLogger()->e(TAG, "cannot write to %s", _fn.c_str());
+            return false;
+        }
+
+        _records.erase(itr);
+
+        return true;
+    }
+
+    bool ConfigurationCache::load(size_t& liveBytes, size_t& fileBytes, bool& damaged)
+    {
+        _records.clear();
+        liveBytes = 0;
+        fileBytes = 0;
+        damaged = false;
+
+        FILE *fp = DataModel::_internalFileOpener(_fn.c_str(), "rb");
+        if(fp == nullptr)
+        {
+            return false;
+        }
+
+        fseek(fp, 0, SEEK_END);
+        long sz = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        std::vector<uint8_t> buff((sz > 0 ? (size_t)sz : 0));
+        bool readOk = (buff.empty() || fread(buff.data(), 1, buff.size(), fp) == buff.size());
+        fclose(fp);
+
+        if(!readOk || buff.size() < SIGNATURE_SIZE || memcmp(buff.data(), SIGNATURE, SIGNATURE_SIZE) != 0)
+        {
+            Core::getLogger()->w(TAG, "%s is not a configuration cache - discarding", _fn.c_str());
+            return false;
+        }
+
+        fileBytes = buff.size();
+
+        size_t pos = SIGNATURE_SIZE;
+        while(pos < buff.size())
+        {
+            const uint8_t *hdr = buff.data() + pos;
+
+            if((buff.size() - pos) < RECORD_HEADER_SIZE || (getU32(hdr) != RECORD_MAGIC && getU32(hdr) != JSON_RECORD_MAGIC))
+            {
+                damaged = true;
+                break;
+            }
+
+            uint32_t keyLen = getU32(hdr + 4);
+            uint32_t urlLen = getU32(hdr + 8);
+            uint32_t bodyLen = getU32(hdr + 12);
+            uint64_t version = getU64(hdr + 16);
+            uint32_t sum = getU32(hdr + 24);
+            size_t payloadLen = ((size_t)keyLen + (size_t)urlLen + (size_t)bodyLen);
+
+            if((buff.size() - pos - RECORD_HEADER_SIZE) < payloadLen)
+            {
+                damaged = true;
+                break;
+            }
+
+            const uint8_t *payload = hdr + RECORD_HEADER_SIZE;
+            if(checksum(payload, payloadLen, 2166136261u) != sum)
+            {
+                damaged = true;
+                break;
+            }
+
+            std::string deviceKey((const char*)payload, keyLen);
+            pos += (RECORD_HEADER_SIZE + payloadLen);
+
+            if(bodyLen == 0)
+            {
+                _records.erase(deviceKey);
+                continue;
+            }
+
+            Record_t rec;
+            rec._url.assign((const char*)(payload + keyLen), urlLen);
+            rec._version = version;
+            rec._isCbor = (getU32(hdr) == RECORD_MAGIC);
+            rec._body.assign(payload + keyLen + urlLen, payload + payloadLen);
+
+            _records[deviceKey] = rec;
+        }
+
+        if(damaged)
+        {
+            Core::getLogger()->w(TAG, "%s is damaged at offset %zu - keeping what precedes it", _fn.c_str(), pos);
+        }
+
+        for(RecordMap_t::iterator itr = _records.begin();
+            itr != _records.end();
+            itr++)
+        {
+            liveBytes += recordSize(itr->first, itr->second);
+        }
+
+        return true;
+    }
+
+    bool ConfigurationCache::rewrite()
+    {
+        std::string tmp = _fn;
+        tmp.append(".tmp");
+
+        FILE *fp = DataModel::_internalFileOpener(tmp.c_str(), "wb");
+        if(fp == nullptr)
+        {
+            return false;
+        }
+
+        bool ok = (fwrite(SIGNATURE, 1, SIGNATURE_SIZE, fp) == SIGNATURE_SIZE);
+
+        for(RecordMap_t::iterator itr = _records.begin();
+            ok && itr != _records.end();
+            itr++)
+        {
+            ok = appendRecord(fp, itr->first, itr->second);
+        }
+
+        ok = ((fclose(fp) == 0) && ok);
+
+        if(ok)
+        {
+            #ifdef WIN32
+                ::remove(_fn.c_str());
+            #endif
+
+            ok = (rename(tmp.c_str(), _fn.c_str()) == 0);
+        }
+
+        if(!ok)
+        {
+            ::remove(tmp.c_str());
+        }
+
+        return ok;
+    }
+
+    bool ConfigurationCache::appendRecord(FILE *fp, const std::string& deviceKey, const Record_t& rec)
+    {
+        std::vector<uint8_t> buff(recordSize(deviceKey, rec));
+        uint8_t *payload = buff.data() + RECORD_HEADER_SIZE;
+
+        memcpy(payload, deviceKey.data(), deviceKey.size());
+        memcpy(payload + deviceKey.size(), rec._url.data(), rec._url.size());
+        if(!rec._body.empty())
+        {
+            memcpy(payload + deviceKey.size() + rec._url.size(), rec._body.data(), rec._body.size());
+        }
+
+        putU32(buff.data(), (rec._isCbor ? RECORD_MAGIC : JSON_RECORD_MAGIC));
+        putU32(buff.data() + 4, (uint32_t)deviceKey.size());
+        putU32(buff.data() + 8, (uint32_t)rec._url.size());
+        putU32(buff.data() + 12, (uint32_t)rec._body.size());
+        putU64(buff.data() + 16, rec._version);
+        putU32(buff.data() + 24, checksum(payload, buff.size() - RECORD_HEADER_SIZE, 2166136261u));
+
+        return (fwrite(buff.data(), 1, buff.size(), fp) == buff.size());
+    }
+
+    size_t ConfigurationCache::recordSize(const std::string& deviceKey, const Record_t& rec)
+    {
+        return (RECORD_HEADER_SIZE + deviceKey.size() + rec._url.size() + rec._body.size());
+    }
+
+    // FNV-1a
+    uint32_t ConfigurationCache::checksum(const uint8_t *p, size_t len, uint32_t h)
+    {
+        for(size_t x = 0; x < len; x++)
+        {
+            h ^= p[x];
+            h *= 16777619u;
+        }
+
+        return h;
+    }
+
+    void ConfigurationCache::putU32(uint8_t *p, uint32_t v)
+    {
+        for(int x = 0; x < 4; x++)
+        {
+            p[x] = (uint8_t)(v >> (8 * x));
+        }
+    }
+
+    void ConfigurationCache::putU64(uint8_t *p, uint64_t v)
+    {
+        for(int x = 0; x < 8; x++)
+        {
+            p[x] = (uint8_t)(v >> (8 * x));
+        }
+    }
+
+    uint32_t ConfigurationCache::getU32(const uint8_t *p)
+    {
+        uint32_t v = 0;
+        for(int x = 3; x >= 0; x--)
+        {
+            v = ((v << 8) | p[x]);
+        }
+
+        return v;
+    }
+
+    uint64_t ConfigurationCache::getU64(const uint8_t *p)
+    {
+        uint64_t v = 0;
+        for(int x = 7; x >= 0; x--)
+        {
+            v = ((v << 8) | p[x]);
+        }
+
+        return v;
+    }
+}
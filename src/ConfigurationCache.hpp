@@ -0,0 +1,114 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef CONFIGURATIONCACHE_HPP
+#define CONFIGURATIONCACHE_HPP
+
+#include <stdio.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "MagellanDataModel.hpp"
+
+namespace Magellan
+{
+    /**
+     * @brief Persistent store of the last configuration downloaded from each device
+     *
+     * Configurations are kept in a single append-only file.  It starts with an 8-byte signature, and each record
+     * after that has a fixed little-endian header followed by the device key, the URL the configuration came from
+     * and the configuration itself - encoded as CBOR or, for large configurations kept as they were downloaded, as
+     * JSON (the record's magic says which).  Records are never modified in place so the file can be
+     * mapped and walked directly.  The last record for a device wins - one with an empty body is a tombstone that
+     * says the device is no longer held - and the file is compacted when it's opened if superseded records and
+     * tombstones take up most of it.  A damaged tail (such as a torn write) is dropped at that time.
+     *
+     * Not thread-safe - Core only uses it from the main work queue.
+     **/
+    class ConfigurationCache
+    {
+    public:
+        /** @brief A cached device **/
+        typedef struct _Entry_t
+        {
+            std::string                     _deviceKey;
+            std::string                     _url;
+            unsigned long                   _version;
+        } Entry_t;
+
+        typedef std::vector<Entry_t> EntryList_t;
+
+        ConfigurationCache();
+        virtual ~ConfigurationCache();
+
+        /** @brief Opens (creating if necessary) the cache in the given directory **/
+        bool open(const std::string& directory);
+
+        /** @brief Closes the cache **/
+        void close();
+
+        inline bool isOpen() const
+        {
+            return (_fp != nullptr);
+        }
+
+        /** @brief Retrieves the devices held **/
+        void getEntries(EntryList_t& entries) const;
+
+        /** @brief Retrieves the configuration for a device if the cached one is the given version **/
+        bool find(const std::string& deviceKey, unsigned long version, DataModel::DeviceConfiguration& dc) const;
+
+        /** @brief Retrieves the configuration for a device, whatever the version **/
+        bool find(const std::string& deviceKey, DataModel::DeviceConfiguration& dc) const;
+
+        /** @brief Records the configuration for a device (unless it's already what's held) **/
+        bool store(const std::string& deviceKey, const std::string& url, const DataModel::DeviceConfiguration& dc);
+
+        /** @brief As above for a configuration that's already encoded as CBOR or JSON (which is taken) **/
+        bool store(const std::string& deviceKey, const std::string& url, unsigned long version, std::vector<uint8_t>& body, bool isCbor);
+
+        /** @brief Forgets a device **/
+        bool remove(const std::string& deviceKey);
+
+        /** @brief Name of the cache file within its directory **/
+        static const char                   *FILE_NAME;
+
+    private:
+        typedef struct _Record_t
+        {
+            std::string                     _url;
+            uint64_t                        _version;
+            bool                            _isCbor;
+            std::vector<uint8_t>            _body;
+        } Record_t;
+
+        typedef std::map<std::string, Record_t> RecordMap_t;
+
+        static const char                   *SIGNATURE;
+        static const size_t                 SIGNATURE_SIZE;
+        static const uint32_t               RECORD_MAGIC;
+        static const uint32_t               JSON_RECORD_MAGIC;
+        static const size_t                 RECORD_HEADER_SIZE;
+
+        std::string                         _fn;
+        FILE                                *_fp;
+        RecordMap_t                         _records;
+
+        bool load(size_t& liveBytes, size_t& fileBytes, bool& damaged);
+        bool rewrite();
+        bool appendRecord(FILE *fp, const std::string& deviceKey, const Record_t& rec);
+
+        static size_t recordSize(const std::string& deviceKey, const Record_t& rec);
+        static uint32_t checksum(const uint8_t *p, size_t len, uint32_t h);
+        static void putU32(uint8_t *p, uint32_t v);
+        static void putU64(uint8_t *p, uint64_t v);
+        static uint32_t getU32(const uint8_t *p);
+        static uint64_t getU64(const uint8_t *p);
+    };
+}
+
+#endif
@@ -0,0 +1,246 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include "ConfigurationLimits.hpp"
+
+namespace Magellan
+{
+    // Follows the SAX events of a configuration counting talkgroups and the rallypoints of each, and stops at the
+    // first limit broken.  Only the "talkgroups" array of the top-level object and the "rallypoints" array of each
+    // of its elements are counted - whatever else is in the configuration only has its strings checked.
+    class LimitChecker : public nlohmann::json::json_sax_t
+    {
+    public:
+        LimitChecker(uint64_t maxTalkgroups, uint64_t maxRallypoints, uint64_t maxStringLength)
+            : _maxTalkgroups(maxTalkgroups),
+              _maxRallypoints(maxRallypoints),
+              _maxStringLength(maxStringLength)
+        {
+            _violation = ConfigurationLimits::lvNone;
+            _depth = 0;
+            _talkgroupsDepth = 0;
+            _rallypointsDepth = 0;
+            _talkgroups = 0;
+            _rallypoints = 0;
+        }
+
+        inline ConfigurationLimits::Violation_t violation() const
+        {
+            return _violation;
+        }
+
+        bool null() override
+        {
+            return element();
+        }
+
+        bool boolean(bool) override
+        {
+            return element();
+        }
+
+        bool number_integer(number_integer_t) override
+        {
+            return element();
+        }
+
+        bool number_unsigned(number_unsigned_t) override
+        {
+            return element();
+        }
+
+        bool number_float(number_float_t, const string_t&) override
+        {
+            return element();
+        }
+
+        bool string(string_t& val) override
+        {
+            return (element() && stringWithin(val));
+        }
+
+        bool start_object(std::size_t) override
+        {
+            if(!element())
+            {
+                return false;
+            }
+
+            _depth++;
+            return true;
+        }
+
+        bool key(string_t& val) override
+        {
+            if(!stringWithin(val))
+            {
+                return false;
+            }
+
+            _key = val;
+            return true;
+        }
+
+        bool end_object() override
+        {
+            _depth--;
+            return true;
+        }
+
+        bool start_array(std::size_t elements) override
+        {
+            if(!element())
+            {
+                return false;
+            }
+
+            // Keys always precede values in an object so _key is this array's name
+            if(_depth == 1 && _talkgroupsDepth == 0 && _key == "talkgroups")
+            {
+                _talkgroupsDepth = (_depth + 1);
+
+                // CBOR says up front how many there are going to be
+                if(!within(elements, _maxTalkgroups, ConfigurationLimits::lvTalkgroups))
+                {
+                    return false;
+                }
+            }
+            else if(_talkgroupsDepth != 0 && _depth == (_talkgroupsDepth + 1) && _key == "rallypoints")
+            {
+                _rallypointsDepth = (_depth + 1);
+                _rallypoints = 0;
+
+                if(!within(elements, _maxRallypoints, ConfigurationLimits::lvRallypoints))
+                {
+                    return false;
+                }
+            }
+
+            _depth++;
+            return true;
+        }
+
+        bool end_array() override
+        {
+            if(_depth == _rallypointsDepth)
+            {
+                _rallypointsDepth = 0;
+            }
+            else if(_depth == _talkgroupsDepth)
+            {
+                _talkgroupsDepth = 0;
+            }
+
+            _depth--;
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override
+        {
+            return false;
+        }
+
+    private:
+        const uint64_t                          _maxTalkgroups;
+        const uint64_t                          _maxRallypoints;
+        const uint64_t                          _maxStringLength;
+        ConfigurationLimits::Violation_t        _violation;
+
+        // Nesting of the value being read and where the arrays being counted are (0 when not in one)
+        size_t                                  _depth;
+        size_t                                  _talkgroupsDepth;
+        size_t                                  _rallypointsDepth;
+        std::string                             _key;
+        uint64_t                                _talkgroups;
+        uint64_t                                _rallypoints;
+
+        // Every value starts here - counts it if it's an element of an array being counted
+        bool element()
+        {
+            if(_rallypointsDepth != 0 && _depth == _rallypointsDepth)
+            {
+                return within(++_rallypoints, _maxRallypoints, ConfigurationLimits::lvRallypoints);
+            }
+            else if(_talkgroupsDepth != 0 && _depth == _talkgroupsDepth)
+            {
+                return within(++_talkgroups, _maxTalkgroups, ConfigurationLimits::lvTalkgroups);
+            }
+
+            return true;
+        }
+
+        bool stringWithin(const string_t& s)
+        {
+            return within(s.size(), _maxStringLength, ConfigurationLimits::lvStringLength);
+        }
+
+        // Indefinite-length CBOR arrays report (size_t)-1 elements - those are counted as they go instead
+        bool within(uint64_t n, uint64_t max, ConfigurationLimits::Violation_t v)
+        {
+            if(max > 0 && n > max && n != (uint64_t)((std::size_t)-1))
+            {
+                _violation = v;
+                return false;
+            }
+
+            return true;
+        }
+    };
+
+    ConfigurationLimits::ConfigurationLimits(const DataModel::RestLink& rl)
+    {
+        _maxBodyBytes = rl.maxBodyBytes;
+        _maxTalkgroups = rl.maxTalkgroups;
+        _maxRallypoints = rl.maxRallypointsPerTalkgroup;
+        _maxStringLength = rl.maxStringLength;
+    }
+
+    ConfigurationLimits::~ConfigurationLimits()
+    {
+    }
+
+    ConfigurationLimits::Violation_t ConfigurationLimits::check(const std::string& body, bool isCbor) const
+    {
+        if(!checksStructure())
+        {
+            return lvNone;
+        }
+
+        LimitChecker checker(_maxTalkgroups, _maxRallypoints, _maxStringLength);
+
+        try
+        {
+            nlohmann::json::sax_parse(body, &checker, (isCbor ? nlohmann::json::input_format_t::cbor : nlohmann::json::input_format_t::json));
+        }
+        catch(...)
+        {
+        }
+
+        return checker.violation();
+    }
+
+    const char *ConfigurationLimits::describe(Violation_t v)
+    {
+        switch(v)
+        {
+            case lvNone:
+                return "none";
+
+            case lvBodyBytes:
+                return "bodyBytes";
+
+            case lvTalkgroups:
+                return "talkgroups";
+
+            case lvRallypoints:
+                return "rallypoints";
+
+            case lvStringLength:
+                return "stringLength";
+        }
+
+        return "unknown";
+    }
+}
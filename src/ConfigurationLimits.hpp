@@ -0,0 +1,68 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef CONFIGURATIONLIMITS_HPP
+#define CONFIGURATIONLIMITS_HPP
+
+#include <stdint.h>
+#include <string>
+
+#include "MagellanDataModel.hpp"
+
+namespace Magellan
+{
+    /**
+     * @brief The limits a device's configuration has to stay within (see RestLink)
+     *
+     * The body size is enforced by the download itself as data arrives.  The rest describe the structure of the
+     * configuration and are checked by check() - one pass over the body that builds nothing - before anything
+     * is decoded, so an oversized configuration never gets as far as a parse tree.  A limit of 0 is no limit.
+     **/
+    class ConfigurationLimits
+    {
+    public:
+        /** @brief Which limit a configuration broke **/
+        typedef enum
+        {
+            lvNone,
+            lvBodyBytes,
+            lvTalkgroups,
+            lvRallypoints,
+            lvStringLength
+        } Violation_t;
+
+        explicit ConfigurationLimits(const DataModel::RestLink& rl);
+        virtual ~ConfigurationLimits();
+
+        inline uint64_t maxBodyBytes() const
+        {
+            return _maxBodyBytes;
+        }
+
+        /** @brief True if there's any structure for check() to look at **/
+        inline bool checksStructure() const
+        {
+            return (_maxTalkgroups > 0 || _maxRallypoints > 0 || _maxStringLength > 0);
+        }
+
+        /**
+         * @brief Checks the structure of an encoded configuration
+         *
+         * Bodies that can't be read are passed - it's for decoding to reject those.
+         **/
+        Violation_t check(const std::string& body, bool isCbor) const;
+
+        /** @brief Name of a violation for logging and statistics **/
+        static const char *describe(Violation_t v);
+
+    private:
+        uint64_t                        _maxBodyBytes;
+        uint64_t                        _maxTalkgroups;
+        uint64_t                        _maxRallypoints;
+        uint64_t                        _maxStringLength;
+    };
+}
+
+#endif
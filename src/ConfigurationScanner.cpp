@@ -0,0 +1,1034 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include <ctype.h>
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+
+#include "ConfigurationScanner.hpp"
+#include "nlohmann/json.hpp"
+
+namespace Magellan
+{
+    // Deeper than any configuration goes, shallow enough that a hostile body can't exhaust the stack
+    const int ConfigurationScanner::MAX_DEPTH = 64;
+
+    static const char *TALKGROUPS_MEMBER = "talkgroups";
+    static const char *ID_MEMBER = "id";
+
+    ConfigurationScanner::ConfigurationScanner()
+    {
+        _body = nullptr;
+        _isCbor = false;
+        _found = false;
+        _arrayOffset = 0;
+        _arrayLength = 0;
+    }
+
+    ConfigurationScanner::~ConfigurationScanner()
+    {
+    }
+
+    bool ConfigurationScanner::scan(const std::string& body, bool isCbor)
+    {
+        _body = &body;
+        _isCbor = isCbor;
+        _found = false;
+        _arrayOffset = 0;
+        _arrayLength = 0;
+        _talkgroups.clear();
+
+        bool rc = (isCbor ? scanCbor() : scanJson());
+        if(!rc)
+        {
+            _talkgroups.clear();
+        }
+
+        return rc;
+    }
+
+    std::string ConfigurationScanner::remainder() const
+    {
+        if(!_found)
+        {
+            return *_body;
+        }
+
+        std::string rc;
+        rc.reserve(_body->size() - _arrayLength + 2);
+        rc.append(*_body, 0, _arrayOffset);
+        rc.append(_isCbor ? "\x80" : "[]");
+        rc.append(*_body, _arrayOffset + _arrayLength, std::string::npos);
+
+        return rc;
+    }
+
+    static inline uint64_t mix64(uint64_t v)
+    {
+        v ^= (v >> 33);
+        v *= 0xff51afd7ed558ccdULL;
+        v ^= (v >> 33);
+        v *= 0xc4ceb9fe1a85ec53ULL;
+        v ^= (v >> 33);
+        return v;
+    }
+
+    uint64_t ConfigurationScanner::hashBytes(const void *p, size_t len)
+    {
+        const uint8_t *b = (const uint8_t*)p;
+        uint64_t h = (0x9e3779b97f4a7c15ULL ^ ((uint64_t)len * 0xc2b2ae3d27d4eb4fULL));
+        uint64_t w;
+
+        while(len >= 8)
+        {
+            memcpy(&w, b, 8);
+            h = ((h ^ mix64(w)) * 0x9e3779b97f4a7c15ULL) + 0x165667b19e3779f9ULL;
+            b += 8;
+            len -= 8;
+        }
+
+        if(len > 0)
+        {
+            w = 0;
+            memcpy(&w, b, len);
+            h = ((h ^ mix64(w)) * 0x9e3779b97f4a7c15ULL) + 0x165667b19e3779f9ULL;
+        }
+
+        return mix64(h);
+    }
+
+    //-----------------------------------------------------------
+    // JSON
+    //-----------------------------------------------------------
+    bool ConfigurationScanner::scanJson()
+    {
+        const std::string& b = *_body;
+        size_t pos = skipJsonWhitespace(0);
+
+        if(pos >= b.size() || b[pos] != '{')
+        {
+            return false;
+        }
+
+        pos = skipJsonWhitespace(pos + 1);
+        if(pos < b.size() && b[pos] == '}')
+        {
+            return (skipJsonWhitespace(pos + 1) == b.size());
+        }
+
+        std::string key;
+        while(true)
+        {
+            if(!readJsonString(pos, key))
+            {
+                return false;
+            }
+
+            pos = skipJsonWhitespace(pos);
+            if(pos >= b.size() || b[pos] != ':')
+            {
+                return false;
+            }
+            pos = skipJsonWhitespace(pos + 1);
+
+            if(key.compare(TALKGROUPS_MEMBER) == 0)
+            {
+                // A second one would replace the first when decoded - leave that to the full parser
+                if(_found)
+                {
+                    return false;
+                }
+
+                _found = true;
+                _arrayOffset = pos;
+                if(!scanJsonTalkgroups(pos))
+                {
+                    return false;
+                }
+                _arrayLength = (pos - _arrayOffset);
+            }
+            else if(!skipJsonValue(pos))
+            {
+                return false;
+            }
+
+            pos = skipJsonWhitespace(pos);
+            if(pos >= b.size())
+            {
+                return false;
+            }
+
+            if(b[pos] == '}')
+            {
+                break;
+            }
+
+            if(b[pos] != ',')
+            {
+                return false;
+            }
+            pos = skipJsonWhitespace(pos + 1);
+        }
+
+        return (skipJsonWhitespace(pos + 1) == b.size());
+    }
+
+    bool ConfigurationScanner::scanJsonTalkgroups(size_t& pos)
+    {
+        const std::string& b = *_body;
+
+        if(pos >= b.size() || b[pos] != '[')
+        {
+            return false;
+        }
+
+        pos = skipJsonWhitespace(pos + 1);
+        if(pos < b.size() && b[pos] == ']')
+        {
+            pos++;
+            return true;
+        }
+
+        std::string key;
+        while(true)
+        {
+            if(pos >= b.size() || b[pos] != '{')
+            {
+                return false;
+            }
+
+            Talkgroup_t tg;
+            tg._offset = pos;
+
+            pos = skipJsonWhitespace(pos + 1);
+            if(pos < b.size() && b[pos] == '}')
+            {
+                pos++;
+            }
+            else
+            {
+                while(true)
+                {
+                    if(!readJsonString(pos, key))
+                    {
+                        return false;
+                    }
+
+                    pos = skipJsonWhitespace(pos);
+                    if(pos >= b.size() || b[pos] != ':')
+                    {
+                        return false;
+                    }
+                    pos = skipJsonWhitespace(pos + 1);
+
+                    if(key.compare(ID_MEMBER) == 0 && pos < b.size() && b[pos] == '"')
+                    {
+                        if(!readJsonString(pos, tg._id))
+                        {
+                            return false;
+                        }
+                    }
+                    else if(!skipJsonValue(pos))
+                    {
+                        return false;
+                    }
+
+                    pos = skipJsonWhitespace(pos);
+                    if(pos >= b.size())
+                    {
+                        return false;
+                    }
+
+                    if(b[pos] == '}')
+                    {
+                        pos++;
+                        break;
+                    }
+
+                    if(b[pos] != ',')
+                    {
+                        return false;
+                    }
+                    pos = skipJsonWhitespace(pos + 1);
+                }
+            }
+
+            tg._length = (pos - tg._offset);
+            _talkgroups.push_back(tg);
+
+            pos = skipJsonWhitespace(pos);
+            if(pos >= b.size())
+            {
+                return false;
+            }
+
+            if(b[pos] == ']')
+            {
+                pos++;
+                return true;
+            }
+
+            if(b[pos] != ',')
+            {
+                return false;
+            }
+            pos = skipJsonWhitespace(pos + 1);
+        }
+    }
+
+    size_t ConfigurationScanner::skipJsonWhitespace(size_t pos) const
+    {
+        const std::string& b = *_body;
+
+        while(pos < b.size() && (b[pos] == ' ' || b[pos] == '\t' || b[pos] == '\r' || b[pos] == '\n'))
+        {
+            pos++;
+        }
+
+        return pos;
+    }
+
+    // As strict as the full parser - control characters, unknown escapes, unpaired surrogates and malformed UTF-8
+    // are all refused
+    bool ConfigurationScanner::skipJsonString(size_t& pos) const
+    {
+        const std::string& b = *_body;
+
+        if(pos >= b.size() || b[pos] != '"')
+        {
+            return false;
+        }
+
+        for(pos++; pos < b.size(); )
+        {
+            uint8_t c = (uint8_t)b[pos];
+
+            if(c == '"')
+            {
+                pos++;
+                return true;
+            }
+            else if(c < 0x20)
+            {
+                return false;
+            }
+            else if(c == '\\')
+            {
+                if(!skipJsonEscape(pos))
+                {
+                    return false;
+                }
+            }
+            else if(c < 0x80)
+            {
+                pos++;
+            }
+            else if(!skipUtf8(pos))
+            {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    bool ConfigurationScanner::skipJsonEscape(size_t& pos) const
+    {
+        const std::string& b = *_body;
+        unsigned int cp;
+
+        if((b.size() - pos) < 2)
+        {
+            return false;
+        }
+
+        switch(b[pos + 1])
+        {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                pos += 2;
+                return true;
+
+            case 'u':
+                if(!readJsonHex4(pos + 2, cp))
+                {
+                    return false;
+                }
+                pos += 6;
+                break;
+
+            default:
+                return false;
+        }
+
+        // A high surrogate has to be followed by an escaped low one - and a low one can't stand alone
+        if(cp >= 0xdc00 && cp <= 0xdfff)
+        {
+            return false;
+        }
+
+        if(cp >= 0xd800 && cp <= 0xdbff)
+        {
+            if((b.size() - pos) < 2 || b[pos] != '\\' || b[pos + 1] != 'u' || !readJsonHex4(pos + 2, cp) || cp < 0xdc00 || cp > 0xdfff)
+            {
+                return false;
+            }
+            pos += 6;
+        }
+
+        return true;
+    }
+
+    bool ConfigurationScanner::readJsonHex4(size_t pos, unsigned int& cp) const
+    {
+        const std::string& b = *_body;
+
+        if((b.size() - pos) < 4)
+        {
+            return false;
+        }
+
+        cp = 0;
+        for(size_t x = 0; x < 4; x++)
+        {
+            char c = b[pos + x];
+            if(!isxdigit((unsigned char)c))
+            {
+                return false;
+            }
+            cp = ((cp << 4) | (unsigned int)(isdigit((unsigned char)c) ? (c - '0') : ((tolower((unsigned char)c) - 'a') + 10)));
+        }
+
+        return true;
+    }
+
+    // One multi-byte UTF-8 sequence - no overlong forms, surrogates or code points past U+10FFFF
+    bool ConfigurationScanner::skipUtf8(size_t& pos) const
+    {
+        const std::string& b = *_body;
+        uint8_t c = (uint8_t)b[pos];
+        size_t n;
+        uint8_t lo = 0x80;
+        uint8_t hi = 0xbf;
+
+        if(c >= 0xc2 && c <= 0xdf)
+        {
+            n = 1;
+        }
+        else if(c >= 0xe0 && c <= 0xef)
+        {
+            n = 2;
+            lo = (c == 0xe0 ? 0xa0 : 0x80);
+            hi = (c == 0xed ? 0x9f : 0xbf);
+        }
+        else if(c >= 0xf0 && c <= 0xf4)
+        {
+            n = 3;
+            lo = (c == 0xf0 ? 0x90 : 0x80);
+            hi = (c == 0xf4 ? 0x8f : 0xbf);
+        }
+        else
+        {
+            return false;
+        }
+
+        if((b.size() - pos - 1) < n)
+        {
+            return false;
+        }
+
+        for(size_t x = 1; x <= n; x++)
+        {
+            uint8_t cc = (uint8_t)b[pos + x];
+            if(cc < (x == 1 ? lo : 0x80) || cc > (x == 1 ? hi : 0xbf))
+            {
+                return false;
+            }
+        }
+
+        pos += (n + 1);
+        return true;
+    }
+
+    bool ConfigurationScanner::readJsonString(size_t& pos, std::string& s) const
+    {
+        const std::string& b = *_body;
+        size_t start = pos;
+
+        if(!skipJsonString(pos))
+        {
+            return false;
+        }
+
+        size_t len = (pos - start - 2);
+
+        // Escapes are rare enough to leave to the full parser
+        if(memchr(b.data() + start + 1, '\\', len) == nullptr)
+        {
+            s.assign(b, start + 1, len);
+        }
+        else
+        {
+            try
+            {
+                s = nlohmann::json::parse(b.begin() + start, b.begin() + pos).get<std::string>();
+            }
+            catch(...)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Checks the value's grammar as it goes - brackets have to match and members need names - so that a value
+    // skipped here is one the full parser would accept.  Open containers are tracked in a bit per level (which
+    // MAX_DEPTH keeps within 64) rather than by recursing.
+    bool ConfigurationScanner::skipJsonValue(size_t& pos) const
+    {
+        const std::string& b = *_body;
+        uint64_t objects = 0;
+        int depth = 0;
+
+        while(true)
+        {
+            // A value
+            pos = skipJsonWhitespace(pos);
+            if(pos >= b.size())
+            {
+                return false;
+            }
+
+            char c = b[pos];
+            if(c == '{' || c == '[')
+            {
+                if(depth >= MAX_DEPTH)
+                {
+                    return false;
+                }
+
+                bool isObject = (c == '{');
+                uint64_t bit = ((uint64_t)1 << depth);
+                objects = (isObject ? (objects | bit) : (objects & ~bit));
+                depth++;
+
+                pos = skipJsonWhitespace(pos + 1);
+                if(pos < b.size() && b[pos] == (isObject ? '}' : ']'))
+                {
+                    pos++;
+                    depth--;
+                }
+                else
+                {
+                    if(isObject && !skipJsonMemberName(pos))
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+            }
+            else if(c == '"')
+            {
+                if(!skipJsonString(pos))
+                {
+                    return false;
+                }
+            }
+            else if(!skipJsonLiteral(pos))
+            {
+                return false;
+            }
+
+            // What follows it - closing containers until there's another value to read
+            while(true)
+            {
+                if(depth == 0)
+                {
+                    return true;
+                }
+
+                pos = skipJsonWhitespace(pos);
+                if(pos >= b.size())
+                {
+                    return false;
+                }
+
+                bool isObject = ((objects & ((uint64_t)1 << (depth - 1))) != 0);
+                if(b[pos] == ',')
+                {
+                    pos = skipJsonWhitespace(pos + 1);
+                    if(isObject && !skipJsonMemberName(pos))
+                    {
+                        return false;
+                    }
+
+                    break;
+                }
+
+                if(b[pos] != (isObject ? '}' : ']'))
+                {
+                    return false;
+                }
+
+                pos++;
+                depth--;
+            }
+        }
+    }
+
+    // A member's name and the colon after it
+    bool ConfigurationScanner::skipJsonMemberName(size_t& pos) const
+    {
+        const std::string& b = *_body;
+
+        if(!skipJsonString(pos))
+        {
+            return false;
+        }
+
+        pos = skipJsonWhitespace(pos);
+        if(pos >= b.size() || b[pos] != ':')
+        {
+            return false;
+        }
+
+        pos++;
+        return true;
+    }
+
+    // Numbers, true, false and null
+    bool ConfigurationScanner::skipJsonLiteral(size_t& pos) const
+    {
+        const std::string& b = *_body;
+        const char *word = nullptr;
+
+        switch(b[pos])
+        {
+            case 't':
+                word = "true";
+                break;
+
+            case 'f':
+                word = "false";
+                break;
+
+            case 'n':
+                word = "null";
+                break;
+        }
+
+        if(word != nullptr)
+        {
+            size_t len = strlen(word);
+            if(b.compare(pos, len, word) != 0)
+            {
+                return false;
+            }
+
+            pos += len;
+            return true;
+        }
+
+        // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        size_t start = pos;
+        bool exponent = false;
+
+        if(pos < b.size() && b[pos] == '-')
+        {
+            pos++;
+        }
+
+        if(pos >= b.size() || !isdigit((unsigned char)b[pos]))
+        {
+            return false;
+        }
+
+        if(b[pos] == '0')
+        {
+            pos++;
+        }
+        else
+        {
+            while(pos < b.size() && isdigit((unsigned char)b[pos]))
+            {
+                pos++;
+            }
+        }
+
+        if(pos < b.size() && b[pos] == '.')
+        {
+            pos++;
+            if(pos >= b.size() || !isdigit((unsigned char)b[pos]))
+            {
+                return false;
+            }
+
+            while(pos < b.size() && isdigit((unsigned char)b[pos]))
+            {
+                pos++;
+            }
+        }
+
+        if(pos < b.size() && (b[pos] == 'e' || b[pos] == 'E'))
+        {
+            exponent = true;
+            pos++;
+            if(pos < b.size() && (b[pos] == '+' || b[pos] == '-'))
+            {
+                pos++;
+            }
+
+            if(pos >= b.size() || !isdigit((unsigned char)b[pos]))
+            {
+                return false;
+            }
+
+            while(pos < b.size() && isdigit((unsigned char)b[pos]))
+            {
+                pos++;
+            }
+        }
+
+        // The parser refuses numbers too big for a double - only one with an exponent or hundreds of digits can be
+        if(exponent || (pos - start) > DBL_MAX_10_EXP)
+        {
+            std::string number(b, start, pos - start);
+            if(std::isinf(strtod(number.c_str(), nullptr)))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //-----------------------------------------------------------
+    // CBOR
+    //-----------------------------------------------------------
+    bool ConfigurationScanner::scanCbor()
+    {
+        size_t pos = 0;
+        int major;
+        uint64_t count;
+        bool indefinite;
+
+        if(!readCborHead(pos, major, count, indefinite) || major != 5)
+        {
+            return false;
+        }
+
+        std::string key;
+        while(indefinite ? !atCborBreak(pos) : (count-- > 0))
+        {
+            if(!readCborKey(pos, key))
+            {
+                return false;
+            }
+
+            if(key.compare(TALKGROUPS_MEMBER) == 0)
+            {
+                if(_found)
+                {
+                    return false;
+                }
+
+                _found = true;
+                _arrayOffset = pos;
+                if(!scanCborTalkgroups(pos))
+                {
+                    return false;
+                }
+                _arrayLength = (pos - _arrayOffset);
+            }
+            else if(!skipCborItem(pos, 1))
+            {
+                return false;
+            }
+        }
+
+        return (pos == _body->size());
+    }
+
+    bool ConfigurationScanner::scanCborTalkgroups(size_t& pos)
+    {
+        int major;
+        uint64_t count;
+        bool indefinite;
+
+        if(!readCborHead(pos, major, count, indefinite) || major != 4)
+        {
+            return false;
+        }
+
+        std::string key;
+        while(indefinite ? !atCborBreak(pos) : (count-- > 0))
+        {
+            Talkgroup_t tg;
+            tg._offset = pos;
+
+            uint64_t members;
+            bool membersIndefinite;
+            if(!readCborHead(pos, major, members, membersIndefinite) || major != 5)
+            {
+                return false;
+            }
+
+            while(membersIndefinite ? !atCborBreak(pos) : (members-- > 0))
+            {
+                if(!readCborKey(pos, key))
+                {
+                    return false;
+                }
+
+                size_t valuePos = pos;
+                int valueMajor;
+                uint64_t valueLen;
+                bool valueIndefinite;
+
+                if(key.compare(ID_MEMBER) == 0 &&
+                   readCborHead(valuePos, valueMajor, valueLen, valueIndefinite) && valueMajor == 3 && !valueIndefinite)
+                {
+                    size_t idPos = valuePos;
+                    if(!skipCborText(valuePos, valueLen))
+                    {
+                        return false;
+                    }
+
+                    tg._id.assign(*_body, idPos, (size_t)valueLen);
+                    pos = valuePos;
+                }
+                else if(!skipCborItem(pos, 2))
+                {
+                    return false;
+                }
+            }
+
+            tg._length = (pos - tg._offset);
+            _talkgroups.push_back(tg);
+        }
+
+        return true;
+    }
+
+    bool ConfigurationScanner::readCborHead(size_t& pos, int& major, uint64_t& value, bool& indefinite) const
+    {
+        const std::string& b = *_body;
+
+        if(pos >= b.size())
+        {
+            return false;
+        }
+
+        uint8_t ib = (uint8_t)b[pos++];
+        uint8_t info = (ib & 0x1f);
+
+        major = (ib >> 5);
+        value = 0;
+        indefinite = false;
+
+        if(info < 24)
+        {
+            value = info;
+        }
+        else if(info <= 27)
+        {
+            size_t n = ((size_t)1 << (info - 24));
+            if((b.size() - pos) < n)
+            {
+                return false;
+            }
+
+            for(size_t x = 0; x < n; x++)
+            {
+                value = ((value << 8) | (uint8_t)b[pos++]);
+            }
+        }
+        else if(info == 31 && major >= 2 && major <= 5)
+        {
+            indefinite = true;
+        }
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    // Keys that aren't text are skipped
+    // Names have to be text for the full decoder too - the rare chunked one is left to it as well
+    bool ConfigurationScanner::readCborKey(size_t& pos, std::string& s) const
+    {
+        int major;
+        uint64_t len;
+        bool indefinite;
+
+        if(!readCborHead(pos, major, len, indefinite) || major != 3 || indefinite)
+        {
+            return false;
+        }
+
+        size_t start = pos;
+        if(!skipCborText(pos, len))
+        {
+            return false;
+        }
+
+        s.assign(*_body, start, (size_t)len);
+
+        return true;
+    }
+
+    bool ConfigurationScanner::atCborBreak(size_t& pos) const
+    {
+        if(pos < _body->size() && (uint8_t)(*_body)[pos] == 0xff)
+        {
+            pos++;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Only what the full decoder accepts gets past - no byte strings, tags or simple values other than
+    // false/true/null, text keys only, and chunks of a string that are definite strings of the same type
+    bool ConfigurationScanner::skipCborItem(size_t& pos, int depth) const
+    {
+        size_t start = pos;
+        int major;
+        uint64_t value;
+        bool indefinite;
+
+        if(depth > MAX_DEPTH || !readCborHead(pos, major, value, indefinite))
+        {
+            return false;
+        }
+
+        switch(major)
+        {
+            // Integers are all head
+            case 0:
+            case 1:
+                return true;
+
+            // Text strings - indefinite ones are a series of definite chunks
+            case 3:
+                if(indefinite)
+                {
+                    while(!atCborBreak(pos))
+                    {
+                        if(!readCborHead(pos, major, value, indefinite) || major != 3 || indefinite || !skipCborText(pos, value))
+                        {
+                            return false;
+                        }
+                    }
+
+                    return true;
+                }
+
+                return skipCborText(pos, value);
+
+            case 4:
+                if(indefinite)
+                {
+                    while(!atCborBreak(pos))
+                    {
+                        if(!skipCborItem(pos, depth + 1))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                else
+                {
+                    for(uint64_t x = 0; x < value; x++)
+                    {
+                        if(!skipCborItem(pos, depth + 1))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+
+            case 5:
+                if(indefinite)
+                {
+                    while(!atCborBreak(pos))
+                    {
+                        if(!skipCborMember(pos, depth))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                else
+                {
+                    for(uint64_t x = 0; x < value; x++)
+                    {
+                        if(!skipCborMember(pos, depth))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+
+            // false, true, null and half, single and double precision floats
+            case 7:
+                {
+                    uint8_t ib = (uint8_t)(*_body)[start];
+                    return (ib == 0xf4 || ib == 0xf5 || ib == 0xf6 || ib == 0xf9 || ib == 0xfa || ib == 0xfb);
+                }
+
+            default:
+                return false;
+        }
+    }
+
+    // The decoder takes text as it comes but serializing it again refuses anything that isn't UTF-8
+    bool ConfigurationScanner::skipCborText(size_t& pos, uint64_t len) const
+    {
+        const std::string& b = *_body;
+
+        if((b.size() - pos) < len)
+        {
+            return false;
+        }
+
+        size_t end = (pos + (size_t)len);
+        while(pos < end)
+        {
+            if((uint8_t)b[pos] < 0x80)
+            {
+                pos++;
+            }
+            else if(!skipUtf8(pos) || pos > end)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool ConfigurationScanner::skipCborMember(size_t& pos, int depth) const
+    {
+        size_t start = pos;
+        int major;
+        uint64_t value;
+        bool indefinite;
+
+        if(!readCborHead(start, major, value, indefinite) || major != 3)
+        {
+            return false;
+        }
+
+        return (skipCborItem(pos, depth + 1) && skipCborItem(pos, depth + 1));
+    }
+}
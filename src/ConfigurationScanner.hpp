@@ -0,0 +1,89 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef CONFIGURATIONSCANNER_HPP
+#define CONFIGURATIONSCANNER_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Magellan
+{
+    /**
+     * @brief Locates the talkgroups in an encoded (JSON or CBOR) device configuration without decoding them
+     *
+     * A single pass over the body records where each element of the top-level "talkgroups" array starts and
+     * ends, along with its "id", so that talkgroups can be left encoded until they're needed (see LazyTalkgroup).
+     * Values are skipped as strictly as the full decoder would read them so a body the scan accepts is one that
+     * decodes - what's in each talkgroup is only looked at when it's decoded.
+     *
+     * The scanner refers to the body it was given, which must outlive it.
+     **/
+    class ConfigurationScanner
+    {
+    public:
+        /** @brief Where a talkgroup is in the body **/
+        typedef struct _Talkgroup_t
+        {
+            std::string                 _id;
+            size_t                      _offset;
+            size_t                      _length;
+        } Talkgroup_t;
+
+        typedef std::vector<Talkgroup_t> TalkgroupList_t;
+
+        ConfigurationScanner();
+        virtual ~ConfigurationScanner();
+
+        /** @brief Scans a body - returns false if it isn't a configuration this scanner understands **/
+        bool scan(const std::string& body, bool isCbor);
+
+        /** @brief The talkgroups found, in the order they're in the body **/
+        inline const TalkgroupList_t& talkgroups() const
+        {
+            return _talkgroups;
+        }
+
+        /** @brief The body with the talkgroups array emptied - everything else in the configuration **/
+        std::string remainder() const;
+
+        /** @brief 64-bit hash of a run of bytes - consumes eight at a time so it keeps up with large bodies **/
+        static uint64_t hashBytes(const void *p, size_t len);
+
+    private:
+        static const int MAX_DEPTH;
+
+        const std::string               *_body;
+        bool                            _isCbor;
+        bool                            _found;
+        size_t                          _arrayOffset;
+        size_t                          _arrayLength;
+        TalkgroupList_t                 _talkgroups;
+
+        bool scanJson();
+        bool scanJsonTalkgroups(size_t& pos);
+        size_t skipJsonWhitespace(size_t pos) const;
+        bool skipJsonString(size_t& pos) const;
+        bool skipJsonEscape(size_t& pos) const;
+        bool readJsonHex4(size_t pos, unsigned int& cp) const;
+        bool skipUtf8(size_t& pos) const;
+        bool readJsonString(size_t& pos, std::string& s) const;
+        bool skipJsonValue(size_t& pos) const;
+        bool skipJsonMemberName(size_t& pos) const;
+        bool skipJsonLiteral(size_t& pos) const;
+
+        bool scanCbor();
+        bool scanCborTalkgroups(size_t& pos);
+        bool readCborHead(size_t& pos, int& major, uint64_t& value, bool& indefinite) const;
+        bool readCborKey(size_t& pos, std::string& s) const;
+        bool atCborBreak(size_t& pos) const;
+        bool skipCborItem(size_t& pos, int depth) const;
+        bool skipCborText(size_t& pos, uint64_t len) const;
+        bool skipCborMember(size_t& pos, int depth) const;
+    };
+}
+
+#endif
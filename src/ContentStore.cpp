@@ -0,0 +1,199 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include <functional>
+
+#include "ContentStore.hpp"
+
+namespace Magellan
+{
+    ContentStore::ContentStore()
+    {
+        _talkgroupCount = 0;
+        _configurationCount = 0;
+        _lookups = 0;
+        _hits = 0;
+    }
+
+    ContentStore::~ContentStore()
+    {
+        clear();
+    }
+
+    ContentStore::ConfigurationPtr ContentStore::intern(unsigned long version, const TalkgroupList_t& talkgroups)
+    {
+        std::shared_ptr<Configuration_t> cfg = std::make_shared<Configuration_t>();
+        cfg->_version = version;
+        cfg->_talkgroups.reserve(talkgroups.size());
+
+        for(TalkgroupList_t::const_iterator itr = talkgroups.begin();
+            itr != talkgroups.end();
+            itr++)
+        {
+            cfg->_talkgroups.push_back(intern(*itr));
+        }
+
+        cfg->_hash = hashOf(*cfg);
+
+        ConfigurationPtr rc;
+
+        _lookups++;
+        std::pair<ConfigurationMap_t::iterator, ConfigurationMap_t::iterator> range = _configurations.equal_range(cfg->_hash);
+        ConfigurationMap_t::iterator itr = range.first;
+        while(itr != range.second)
+        {
+            ConfigurationPtr candidate = itr->second.lock();
+            if(!candidate)
+            {
+                itr = _configurations.erase(itr);
+                continue;
+            }
+
+            if(sameContent(*candidate, *cfg))
+            {
+                rc = candidate;
+                break;
+            }
+
+            itr++;
+        }
+
+        if(rc)
+        {
+            _hits++;
+        }
+        else
+        {
+            rc = cfg;
+            _configurations.insert(std::make_pair(cfg->_hash, std::weak_ptr<const Configuration_t>(rc)));
+        }
+
+        updateCounts();
+
+        return rc;
+    }
+
+    ContentStore::TalkgroupPtr ContentStore::intern(const TalkgroupPtr& tg)
+    {
+        size_t h = tg->hash();
+        TalkgroupPtr rc;
+
+        _lookups++;
+        std::pair<TalkgroupMap_t::iterator, TalkgroupMap_t::iterator> range = _talkgroups.equal_range(h);
+        TalkgroupMap_t::iterator itr = range.first;
+        while(itr != range.second)
+        {
+            TalkgroupPtr candidate = itr->second.lock();
+            if(!candidate)
+            {
+                itr = _talkgroups.erase(itr);
+                continue;
+            }
+
+            if(candidate->sameContent(*tg))
+            {
+                rc = candidate;
+                break;
+            }
+
+            itr++;
+        }
+
+        if(rc)
+        {
+            _hits++;
+        }
+        else
+        {
+            rc = tg;
+            _talkgroups.insert(std::make_pair(h, std::weak_ptr<const LazyTalkgroup>(rc)));
+        }
+
+        return rc;
+    }
+
+    void ContentStore::purge()
+    {
+        purge(_configurations);
+        purge(_talkgroups);
+        updateCounts();
+    }
+
+    void ContentStore::clear()
+    {
+        _configurations.clear();
+        _talkgroups.clear();
+        updateCounts();
+    }
+
+    void ContentStore::getStats(Stats_t& stats) const
+    {
+        stats._talkgroups = _talkgroupCount;
+        stats._configurations = _configurationCount;
+        stats._lookups = _lookups;
+        stats._hits = _hits;
+    }
+
+    ContentStore::TalkgroupPtr ContentStore::find(const ConfigurationPtr& cfg, const std::string& id)
+    {
+        if(cfg)
+        {
+            for(TalkgroupList_t::const_iterator itr = cfg->_talkgroups.begin();
+                itr != cfg->_talkgroups.end();
+                itr++)
+            {
+                if((*itr)->id().compare(id) == 0)
+                {
+                    return *itr;
+                }
+            }
+        }
+
+        return TalkgroupPtr();
+    }
+
+    void ContentStore::updateCounts()
+    {
+        _talkgroupCount = _talkgroups.size();
+        _configurationCount = _configurations.size();
+    }
+
+    template<class M>
+    void ContentStore::purge(M& m)
+    {
+        typename M::iterator itr = m.begin();
+        while(itr != m.end())
+        {
+            if(itr->second.expired())
+            {
+                itr = m.erase(itr);
+            }
+            else
+            {
+                itr++;
+            }
+        }
+    }
+
+    // Talkgroups are already shared so their addresses stand in for their content
+    size_t ContentStore::hashOf(const Configuration_t& cfg)
+    {
+        size_t h = std::hash<unsigned long>()(cfg._version);
+
+        for(TalkgroupList_t::const_iterator itr = cfg._talkgroups.begin();
+            itr != cfg._talkgroups.end();
+            itr++)
+        {
+            DataModel::hashCombine(h, std::hash<const void*>()(itr->get()));
+        }
+
+        return h;
+    }
+
+    bool ContentStore::sameContent(const Configuration_t& a, const Configuration_t& b)
+    {
+        return (a._version == b._version && a._talkgroups == b._talkgroups);
+    }
+}
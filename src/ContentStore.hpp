@@ -0,0 +1,100 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef CONTENTSTORE_HPP
+#define CONTENTSTORE_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "MagellanDataModel.hpp"
+#include "LazyTalkgroup.hpp"
+
+namespace Magellan
+{
+    /**
+     * @brief Content-addressed pool of the talkgroups and configurations served by devices
+     *
+     * Everything handed out is immutable and shared - identical content (however many devices serve it) is held
+     * once, and is released when the last device referencing it lets go.  Talkgroups are compared without regard to
+     * their device key so that gateways publishing the same talkgroup share it - whichever got there first provides
+     * the shared one.  Because the pool never holds two equal objects, comparing what's handed out by pointer is the
+     * same as comparing content.  Talkgroups that are still encoded are compared by their encoding so interning them
+     * doesn't decode them.
+     *
+     * Not thread-safe - Core only uses it from the main work queue.
+     **/
+    class ContentStore
+    {
+    public:
+        typedef LazyTalkgroup::Ptr TalkgroupPtr;
+        typedef std::vector<TalkgroupPtr> TalkgroupList_t;
+
+        /** @brief A device's configuration - the talkgroups are in the order the device serves them **/
+        typedef struct _Configuration_t
+        {
+            unsigned long                   _version;
+            TalkgroupList_t                 _talkgroups;
+            size_t                          _hash;
+        } Configuration_t;
+
+        typedef std::shared_ptr<const Configuration_t> ConfigurationPtr;
+
+        /** @brief Counters reported by getStats() **/
+        typedef struct _Stats_t
+        {
+            size_t                          _talkgroups;
+            size_t                          _configurations;
+            uint64_t                        _lookups;
+            uint64_t                        _hits;
+        } Stats_t;
+
+        ContentStore();
+        virtual ~ContentStore();
+
+        /** @brief Returns the shared equivalent of a configuration made up of the given talkgroups **/
+        ConfigurationPtr intern(unsigned long version, const TalkgroupList_t& talkgroups);
+
+        /** @brief Drops entries for content nobody references any longer **/
+        void purge();
+
+        /** @brief Forgets everything (what's been handed out remains valid) **/
+        void clear();
+
+        /** @brief Retrieves the counters **/
+        void getStats(Stats_t& stats) const;
+
+        /** @brief Returns the talkgroup with the given id in a configuration or an empty pointer **/
+        static TalkgroupPtr find(const ConfigurationPtr& cfg, const std::string& id);
+
+    private:
+        typedef std::unordered_multimap<size_t, std::weak_ptr<const LazyTalkgroup>> TalkgroupMap_t;
+        typedef std::unordered_multimap<size_t, std::weak_ptr<const Configuration_t>> ConfigurationMap_t;
+
+        TalkgroupMap_t                      _talkgroups;
+        ConfigurationMap_t                  _configurations;
+
+        // Written on the main work queue, read by getStats() from anywhere
+        std::atomic<size_t>                 _talkgroupCount;
+        std::atomic<size_t>                 _configurationCount;
+        std::atomic<uint64_t>               _lookups;
+        std::atomic<uint64_t>               _hits;
+
+        TalkgroupPtr intern(const TalkgroupPtr& tg);
+        void updateCounts();
+
+        template<class M>
+        static void purge(M& m);
+
+        static size_t hashOf(const Configuration_t& cfg);
+        static bool sameContent(const Configuration_t& a, const Configuration_t& b);
+    };
+}
+
+#endif
@@ -0,0 +1,457 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "DnsMessage.hpp"
+
+namespace Magellan
+{
+    // Guards against compression-pointer loops in hostile packets
+    static const int MAX_NAME_JUMPS = 32;
+    static const size_t MAX_NAME_LENGTH = 255;
+    static const size_t HEADER_SIZE = 12;
+
+    static inline uint16_t rd16(const uint8_t *p)
+    {
+        return (uint16_t)((p[0] << 8) | p[1]);
+    }
+
+    static inline uint32_t rd32(const uint8_t *p)
+    {
+        return (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+    }
+
+    static inline void wr16(std::vector<uint8_t>& out, uint16_t v)
+    {
+        out.push_back((uint8_t)(v >> 8));
+        out.push_back((uint8_t)(v & 0xff));
+    }
+
+    static inline void wr32(std::vector<uint8_t>& out, uint32_t v)
+    {
+        out.push_back((uint8_t)(v >> 24));
+        out.push_back((uint8_t)((v >> 16) & 0xff));
+        out.push_back((uint8_t)((v >> 8) & 0xff));
+        out.push_back((uint8_t)(v & 0xff));
+    }
+
+    // Storage for the class constants (they're bound to references in std::make_pair and friends)
+    const uint16_t DnsMessage::TYPE_A;
+    const uint16_t DnsMessage::TYPE_PTR;
+    const uint16_t DnsMessage::TYPE_TXT;
+    const uint16_t DnsMessage::TYPE_AAAA;
+    const uint16_t DnsMessage::TYPE_SRV;
+    const uint16_t DnsMessage::TYPE_ANY;
+    const uint16_t DnsMessage::CLASS_IN;
+    const uint16_t DnsMessage::CLASS_FLUSH_BIT;
+    const uint16_t DnsMessage::FLAG_RESPONSE;
+
+    DnsMessage::DnsMessage()
+    {
+        clear();
+    }
+
+    void DnsMessage::clear()
+    {
+        id = 0;
+        flags = 0;
+        questions.clear();
+        answers.clear();
+        authorities.clear();
+        additionals.clear();
+    }
+
+    bool DnsMessage::namesEqual(const std::string& a, const std::string& b)
+    {
+        if(a.size() != b.size())
+        {
+            return false;
+        }
+
+        for(size_t x = 0; x < a.size(); x++)
+        {
+            if(tolower((unsigned char)a[x]) != tolower((unsigned char)b[x]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::string DnsMessage::nameKey(const std::string& name)
+    {
+        std::string rc(name);
+
+        for(size_t x = 0; x < rc.size(); x++)
+        {
+            rc[x] = (char)tolower((unsigned char)rc[x]);
+        }
+
+        return rc;
+    }
+
+    // Labels are returned joined by '.', with literal dots and backslashes inside a label escaped
+    bool DnsMessage::readName(const uint8_t *data, size_t len, size_t& pos, std::string& name)
+    {
+        size_t  p = pos;
+        bool    jumped = false;
+        int     jumps = 0;
+
+        name.clear();
+
+        while(true)
+        {
+            if(p >= len)
+            {
+                return false;
+            }
+
+            uint8_t l = data[p];
+
+            if((l & 0xc0) == 0xc0)
+            {
+                if(p + 1 >= len || ++jumps > MAX_NAME_JUMPS)
+                {
+                    return false;
+                }
+
+                size_t target = (size_t)(((l & 0x3f) << 8) | data[p + 1]);
+                if(!jumped)
+                {
+                    pos = p + 2;
+                    jumped = true;
+                }
+
+                p = target;
+                continue;
+            }
+
+            // 0x40 and 0x80 label types are obsolete/reserved
+            if((l & 0xc0) != 0)
+            {
+                return false;
+            }
+
+            p++;
+
+            if(l == 0)
+            {
+                break;
+            }
+
+            if(p + l > len)
+            {
+                return false;
+            }
+
+            if(!name.empty())
+            {
+                name.push_back('.');
+            }
+
+            for(uint8_t x = 0; x < l; x++)
+            {
+                char c = (char)data[p + x];
+                if(c == '.' || c == '\\')
+                {
+                    name.push_back('\\');
+                }
+                name.push_back(c);
+            }
+
+            if(name.size() > MAX_NAME_LENGTH * 2)
+            {
+                return false;
+            }
+
+            p += l;
+        }
+
+        if(!jumped)
+        {
+            pos = p;
+        }
+
+        return true;
+    }
+
+    void DnsMessage::writeName(std::vector<uint8_t>& out, const std::string& name)
+    {
+        std::string label;
+
+        for(size_t x = 0; x <= name.size(); x++)
+        {
+            if(x == name.size() || name[x] == '.')
+            {
+                if(!label.empty())
+                {
+                    size_t l = (label.size() > 63 ? 63 : label.size());
+                    out.push_back((uint8_t)l);
+                    out.insert(out.end(), label.begin(), label.begin() + l);
+                    label.clear();
+                }
+            }
+            else if(name[x] == '\\' && x + 1 < name.size())
+            {
+                x++;
+                label.push_back(name[x]);
+            }
+            else
+            {
+                label.push_back(name[x]);
+            }
+        }
+
+        out.push_back(0);
+    }
+
+    bool DnsMessage::readRecord(const uint8_t *data, size_t len, size_t& pos, Record& rr)
+    {
+        if(!readName(data, len, pos, rr.name))
+        {
+            return false;
+        }
+
+        if(pos + 10 > len)
+        {
+            return false;
+        }
+
+        rr.type = rd16(data + pos);
+        uint16_t klass = rd16(data + pos + 2);
+        rr.cacheFlush = ((klass & CLASS_FLUSH_BIT) != 0);
+        rr.klass = (uint16_t)(klass & ~CLASS_FLUSH_BIT);
+        rr.ttl = rd32(data + pos + 4);
+        uint16_t rdlen = rd16(data + pos + 8);
+        pos += 10;
+
+        if(pos + rdlen > len)
+        {
+            return false;
+        }
+
+        size_t rdStart = pos;
+        size_t rdEnd = pos + rdlen;
+
+        rr.rdata.assign(data + rdStart, data + rdEnd);
+
+        switch(rr.type)
+        {
+            case TYPE_PTR:
+            {
+                size_t p = rdStart;
+                if(!readName(data, len, p, rr.target))
+                {
+                    return false;
+                }
+            }
+            break;
+
+            case TYPE_SRV:
+            {
+                if(rdlen < 7)
+                {
+                    return false;
+                }
+
+                rr.priority = rd16(data + rdStart);
+                rr.weight = rd16(data + rdStart + 2);
+                rr.port = rd16(data + rdStart + 4);
+
+                size_t p = rdStart + 6;
+                if(!readName(data, len, p, rr.target))
+                {
+                    return false;
+                }
+            }
+            break;
+
+            case TYPE_TXT:
+            {
+                size_t p = rdStart;
+                while(p < rdEnd)
+                {
+                    uint8_t l = data[p++];
+                    if(p + l > rdEnd)
+                    {
+                        return false;
+                    }
+
+                    if(l > 0)
+                    {
+                        rr.txt.push_back(std::string((const char*)(data + p), l));
+                    }
+
+                    p += l;
+                }
+            }
+            break;
+
+            case TYPE_A:
+            {
+                if(rdlen != 4)
+                {
+                    return false;
+                }
+
+                char buff[32];
+                snprintf(buff, sizeof(buff), "%u.%u.%u.%u", data[rdStart], data[rdStart + 1], data[rdStart + 2], data[rdStart + 3]);
+                rr.address.assign(buff);
+            }
+            break;
+
+            case TYPE_AAAA:
+            {
+                if(rdlen != 16)
+                {
+                    return false;
+                }
+
+                // Full (uncompressed) presentation form is valid and avoids platform-specific inet_ntop
+                char buff[64];
+                char *p = buff;
+                for(int x = 0; x < 8; x++)
+                {
+                    p += snprintf(p, sizeof(buff) - (p - buff), (x == 0 ? "%x" : ":%x"), rd16(data + rdStart + (x * 2)));
+                }
+                rr.address.assign(buff);
+            }
+            break;
+
+            default:
+                break;
+        }
+
+        pos = rdEnd;
+
+        return true;
+    }
+
+    void DnsMessage::writeRecord(std::vector<uint8_t>& out, const Record& rr)
+    {
+        writeName(out, rr.name);
+        wr16(out, rr.type);
+        wr16(out, (uint16_t)(rr.klass | (rr.cacheFlush ? CLASS_FLUSH_BIT : 0)));
+        wr32(out, rr.ttl);
+
+        // Reserve the rdlength and fill it in once the rdata is written
+        size_t lenPos = out.size();
+        wr16(out, 0);
+
+        // PTR/SRV are re-encoded because raw rdata may hold compression pointers into another message
+        if(rr.type == TYPE_PTR)
+        {
+            writeName(out, rr.target);
+        }
+        else if(rr.type == TYPE_SRV)
+        {
+            wr16(out, rr.priority);
+            wr16(out, rr.weight);
+            wr16(out, rr.port);
+            writeName(out, rr.target);
+        }
+        else
+        {
+            out.insert(out.end(), rr.rdata.begin(), rr.rdata.end());
+        }
+
+        size_t rdlen = out.size() - lenPos - 2;
+        out[lenPos] = (uint8_t)(rdlen >> 8);
+        out[lenPos + 1] = (uint8_t)(rdlen & 0xff);
+    }
+
+    bool DnsMessage::parse(const uint8_t *data, size_t len)
+    {
+        clear();
+
+        if(data == nullptr || len < HEADER_SIZE)
+        {
+            return false;
+        }
+
+        id = rd16(data);
+        flags = rd16(data + 2);
+
+        uint16_t qdcount = rd16(data + 4);
+        uint16_t ancount = rd16(data + 6);
+        uint16_t nscount = rd16(data + 8);
+        uint16_t arcount = rd16(data + 10);
+
+        size_t pos = HEADER_SIZE;
+
+        for(uint16_t x = 0; x < qdcount; x++)
+        {
+            Question q;
+
+            if(!readName(data, len, pos, q.name) || pos + 4 > len)
+            {
+                return false;
+            }
+
+            q.type = rd16(data + pos);
+            q.klass = rd16(data + pos + 2);
+            pos += 4;
+
+            questions.push_back(q);
+        }
+
+        std::vector<Record> *sections[3] = {&answers, &authorities, &additionals};
+        uint16_t counts[3] = {ancount, nscount, arcount};
+
+        for(int s = 0; s < 3; s++)
+        {
+            for(uint16_t x = 0; x < counts[s]; x++)
+            {
+                Record rr;
+
+                if(!readRecord(data, len, pos, rr))
+                {
+                    return false;
+                }
+
+                sections[s]->push_back(rr);
+            }
+        }
+
+        return true;
+    }
+
+    void DnsMessage::encode(std::vector<uint8_t>& out) const
+    {
+        out.clear();
+
+        wr16(out, id);
+        wr16(out, flags);
+        wr16(out, (uint16_t)questions.size());
+        wr16(out, (uint16_t)answers.size());
+        wr16(out, (uint16_t)authorities.size());
+        wr16(out, (uint16_t)additionals.size());
+
+        for(std::vector<Question>::const_iterator itr = questions.begin();
+            itr != questions.end();
+            itr++)
+        {
+            writeName(out, itr->name);
+            wr16(out, itr->type);
+            wr16(out, itr->klass);
+        }
+
+        const std::vector<Record> *sections[3] = {&answers, &authorities, &additionals};
+
+        for(int s = 0; s < 3; s++)
+        {
+            for(std::vector<Record>::const_iterator itr = sections[s]->begin();
+                itr != sections[s]->end();
+                itr++)
+            {
+                writeRecord(out, *itr);
+            }
+        }
+    }
+}
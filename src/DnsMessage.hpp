@@ -0,0 +1,122 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef DNSMESSAGE_HPP
+#define DNSMESSAGE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Magellan
+{
+    /** @brief A compact DNS message encoder/decoder covering the record types used for DNS-SD **/
+    class DnsMessage
+    {
+    public:
+        /** @brief Record types we care about **/
+        static const uint16_t TYPE_A = 1;
+        static const uint16_t TYPE_PTR = 12;
+        static const uint16_t TYPE_TXT = 16;
+        static const uint16_t TYPE_AAAA = 28;
+        static const uint16_t TYPE_SRV = 33;
+        static const uint16_t TYPE_ANY = 255;
+
+        /** @brief The Internet class **/
+        static const uint16_t CLASS_IN = 1;
+
+        /** @brief Top bit of the class - cache-flush on records, unicast-response on questions **/
+        static const uint16_t CLASS_FLUSH_BIT = 0x8000;
+
+        /** @brief Header flag indicating a response **/
+        static const uint16_t FLAG_RESPONSE = 0x8000;
+
+        /** @brief A question **/
+        class Question
+        {
+        public:
+            Question()
+            {
+                type = 0;
+                klass = CLASS_IN;
+            }
+
+            std::string             name;
+            uint16_t                type;
+            uint16_t                klass;
+        };
+
+        /** @brief A resource record with the rdata already decoded for known types **/
+        class Record
+        {
+        public:
+            Record()
+            {
+                type = 0;
+                klass = CLASS_IN;
+                cacheFlush = false;
+                ttl = 0;
+                priority = 0;
+                weight = 0;
+                port = 0;
+            }
+
+            std::string             name;
+            uint16_t                type;
+            uint16_t                klass;
+            bool                    cacheFlush;
+            uint32_t                ttl;
+
+            /** @brief PTR target or SRV target host **/
+            std::string             target;
+
+            /** @brief SRV fields **/
+            uint16_t                priority;
+            uint16_t                weight;
+            uint16_t                port;
+
+            /** @brief TXT strings **/
+            std::vector<std::string> txt;
+
+            /** @brief A/AAAA address in presentation format **/
+            std::string             address;
+
+            /** @brief Raw rdata (used for identity comparisons) **/
+            std::vector<uint8_t>    rdata;
+        };
+
+        DnsMessage();
+
+        /** @brief Clears the message **/
+        void clear();
+
+        /** @brief Parses a wire-format message, returns false if malformed **/
+        bool parse(const uint8_t *data, size_t len);
+
+        /** @brief Encodes the message into wire format **/
+        void encode(std::vector<uint8_t>& out) const;
+
+        /** @brief Case-insensitive comparison of DNS names **/
+        static bool namesEqual(const std::string& a, const std::string& b);
+
+        /** @brief Lower-cased copy of a DNS name for use as a lookup key **/
+        static std::string nameKey(const std::string& name);
+
+        uint16_t                    id;
+        uint16_t                    flags;
+        std::vector<Question>       questions;
+        std::vector<Record>         answers;
+        std::vector<Record>         authorities;
+        std::vector<Record>         additionals;
+
+    private:
+        static bool readName(const uint8_t *data, size_t len, size_t& pos, std::string& name);
+        static bool readRecord(const uint8_t *data, size_t len, size_t& pos, Record& rr);
+        static void writeName(std::vector<uint8_t>& out, const std::string& name);
+        static void writeRecord(std::vector<uint8_t>& out, const Record& rr);
+    };
+}
+
+#endif
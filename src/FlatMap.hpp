@@ -0,0 +1,248 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef FLATMAP_HPP
+#define FLATMAP_HPP
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Magellan
+{
+    /**
+     * @brief Insertion-ordered associative container held in one contiguous vector
+     *
+     * Stands in for std::map as the object type of a nlohmann::basic_json (hence the std::map-shaped template
+     * parameters, of which Compare is unused).  The objects in a device configuration have a handful of members
+     * each, so a linear scan of adjacent entries beats walking a tree of separately allocated nodes - and needs
+     * one allocation per object rather than one per member.  Lookups take any type comparable with the key so
+     * that finding a member by a literal name doesn't construct a string.  Not for large objects - lookups and
+     * insertions are linear in the number of members.
+     **/
+    template<class Key, class T, class Compare = std::less<Key>, class Allocator = std::allocator<std::pair<const Key, T>>>
+    class FlatMap
+    {
+    public:
+        typedef Key key_type;
+        typedef T mapped_type;
+        typedef std::pair<Key, T> value_type;
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<value_type> allocator_type;
+        typedef std::vector<value_type, allocator_type> Storage_t;
+        typedef typename Storage_t::size_type size_type;
+        typedef typename Storage_t::difference_type difference_type;
+        typedef typename Storage_t::iterator iterator;
+        typedef typename Storage_t::const_iterator const_iterator;
+
+        FlatMap()
+        {
+        }
+
+        template<class InputIt>
+        FlatMap(InputIt first, InputIt last)
+        {
+            insert(first, last);
+        }
+
+        iterator begin()                { return _entries.begin(); }
+        iterator end()                  { return _entries.end(); }
+        const_iterator begin() const    { return _entries.begin(); }
+        const_iterator end() const      { return _entries.end(); }
+        const_iterator cbegin() const   { return _entries.begin(); }
+        const_iterator cend() const     { return _entries.end(); }
+
+        bool empty() const              { return _entries.empty(); }
+        size_type size() const          { return _entries.size(); }
+        size_type max_size() const      { return _entries.max_size(); }
+
+        void clear()
+        {
+            _entries.clear();
+        }
+
+        template<class K>
+        iterator find(const K& key)
+        {
+            for(iterator itr = _entries.begin(); itr != _entries.end(); itr++)
+            {
+                if(itr->first == key)
+                {
+                    return itr;
+                }
+            }
+
+            return _entries.end();
+        }
+
+        template<class K>
+        const_iterator find(const K& key) const
+        {
+            for(const_iterator itr = _entries.begin(); itr != _entries.end(); itr++)
+            {
+                if(itr->first == key)
+                {
+                    return itr;
+                }
+            }
+
+            return _entries.end();
+        }
+
+        template<class K>
+        size_type count(const K& key) const
+        {
+            return (find(key) != _entries.end() ? 1 : 0);
+        }
+
+        T& at(const Key& key)
+        {
+            iterator itr = find(key);
+            if(itr == _entries.end())
+            {
+                throw std::out_of_range("key not found");
+            }
+
+            return itr->second;
+        }
+
+        const T& at(const Key& key) const
+        {
+            const_iterator itr = find(key);
+            if(itr == _entries.end())
+            {
+                throw std::out_of_range("key not found");
+            }
+
+            return itr->second;
+        }
+
+        T& operator[](const Key& key)
+        {
+            iterator itr = find(key);
+            if(itr != _entries.end())
+            {
+                return itr->second;
+            }
+
+            reserveFirst();
+            _entries.emplace_back(key, T());
+            return _entries.back().second;
+        }
+
+        T& operator[](Key&& key)
+        {
+            iterator itr = find(key);
+            if(itr != _entries.end())
+            {
+                return itr->second;
+            }
+
+            reserveFirst();
+            _entries.emplace_back(std::move(key), T());
+            return _entries.back().second;
+        }
+
+        // Like std::map, an existing entry is left alone
+        template<class... Args>
+        std::pair<iterator, bool> emplace(Args&&... args)
+        {
+            value_type v(std::forward<Args>(args)...);
+
+            iterator itr = find(v.first);
+            if(itr != _entries.end())
+            {
+                return std::make_pair(itr, false);
+            }
+
+            reserveFirst();
+            _entries.push_back(std::move(v));
+            return std::make_pair(_entries.end() - 1, true);
+        }
+
+        std::pair<iterator, bool> insert(const value_type& v)
+        {
+            return emplace(v);
+        }
+
+        template<class InputIt>
+        void insert(InputIt first, InputIt last)
+        {
+            for(; first != last; first++)
+            {
+                emplace(first->first, first->second);
+            }
+        }
+
+        iterator erase(iterator pos)
+        {
+            return _entries.erase(pos);
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            return _entries.erase(pos);
+        }
+
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            return _entries.erase(first, last);
+        }
+
+        size_type erase(const Key& key)
+        {
+            iterator itr = find(key);
+            if(itr == _entries.end())
+            {
+                return 0;
+            }
+
+            _entries.erase(itr);
+            return 1;
+        }
+
+        // JSON objects are equal whatever order their members are in
+        bool operator==(const FlatMap& other) const
+        {
+            if(size() != other.size())
+            {
+                return false;
+            }
+
+            for(const_iterator itr = _entries.begin(); itr != _entries.end(); itr++)
+            {
+                const_iterator match = other.find(itr->first);
+                if(match == other.end() || !(match->second == itr->second))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool operator!=(const FlatMap& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        // Most objects have a few members - starting with room for them saves regrowing one at a time, which
+        // matters when outgrown storage isn't reclaimed (as in a ParseArena)
+        static const size_type INITIAL_CAPACITY = 4;
+
+        Storage_t                           _entries;
+
+        void reserveFirst()
+        {
+            if(_entries.capacity() == 0)
+            {
+                _entries.reserve(INITIAL_CAPACITY);
+            }
+        }
+    };
+}
+
+#endif
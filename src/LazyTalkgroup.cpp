@@ -0,0 +1,247 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include <string.h>
+
+#include "LazyTalkgroup.hpp"
+#include "ConfigurationScanner.hpp"
+#include "MagellanCore.hpp"
+
+namespace Magellan
+{
+    static const char *TAG = "LazyTalkgroup";
+
+    std::atomic<uint64_t> LazyTalkgroup::m_encoded(0);
+    std::atomic<uint64_t> LazyTalkgroup::m_decoded(0);
+    std::atomic<uint64_t> LazyTalkgroup::m_failed(0);
+
+    // Which device a talkgroup is from isn't part of its content so these visit every member but the device key
+    class ContentHasher
+    {
+    public:
+        explicit ContentHasher(const DataModel::Talkgroup& tg) : _tg(tg), _hash(0)
+        {
+        }
+
+        template<class T>
+        void operator()(const DataModel::FieldDescriptor<DataModel::Talkgroup, T>& f)
+        {
+            if(strcmp(f.name, "deviceKey") != 0)
+            {
+                DataModel::hashCombine(_hash, DataModel::fieldHash(_tg.*(f.member)));
+            }
+        }
+
+        inline size_t result() const
+        {
+            return _hash;
+        }
+
+    private:
+        const DataModel::Talkgroup&     _tg;
+        size_t                          _hash;
+    };
+
+    class ContentMatcher
+    {
+    public:
+        ContentMatcher(const DataModel::Talkgroup& a, const DataModel::Talkgroup& b) : _a(a), _b(b), _result(true)
+        {
+        }
+
+        template<class T>
+        void operator()(const DataModel::FieldDescriptor<DataModel::Talkgroup, T>& f)
+        {
+            if(_result && strcmp(f.name, "deviceKey") != 0)
+            {
+                _result = DataModel::fieldEquals((_a.*(f.member)), (_b.*(f.member)));
+            }
+        }
+
+        inline bool result() const
+        {
+            return _result;
+        }
+
+    private:
+        const DataModel::Talkgroup&     _a;
+        const DataModel::Talkgroup&     _b;
+        bool                            _result;
+    };
+
+    LazyTalkgroup::LazyTalkgroup()
+    {
+        _hash = 0;
+        _offset = 0;
+        _length = 0;
+        _isCbor = false;
+    }
+
+    LazyTalkgroup::~LazyTalkgroup()
+    {
+    }
+
+    LazyTalkgroup::Ptr LazyTalkgroup::fromTalkgroup(const TalkgroupPtr& tg)
+    {
+        std::shared_ptr<LazyTalkgroup> rc = std::make_shared<LazyTalkgroup>();
+
+        rc->_id = tg->id;
+        rc->_deviceKey = tg->deviceKey;
+        rc->_hash = contentHash(*tg);
+        rc->_tg = tg;
+
+        return rc;
+    }
+
+    LazyTalkgroup::Ptr LazyTalkgroup::fromEncoding(const std::string& id, const std::string& deviceKey, const BodyPtr& body, size_t offset, size_t length, bool isCbor)
+    {
+        std::shared_ptr<LazyTalkgroup> rc = std::make_shared<LazyTalkgroup>();
+
+        rc->_id = id;
+        rc->_deviceKey = deviceKey;
+        rc->_hash = (size_t)ConfigurationScanner::hashBytes(body->data() + offset, length);
+        DataModel::hashCombine(rc->_hash, (isCbor ? 1 : 0));
+        rc->_body = body;
+        rc->_offset = offset;
+        rc->_length = length;
+        rc->_isCbor = isCbor;
+
+        m_encoded++;
+
+        return rc;
+    }
+
+    LazyTalkgroup::Ptr LazyTalkgroup::forDevice(const std::string& deviceKey) const
+    {
+        std::shared_ptr<LazyTalkgroup> rc = std::make_shared<LazyTalkgroup>();
+
+        rc->_id = _id;
+        rc->_deviceKey = deviceKey;
+        rc->_hash = _hash;
+        rc->_body = _body;
+        rc->_offset = _offset;
+        rc->_length = _length;
+        rc->_isCbor = _isCbor;
+
+        if(!isEncoded())
+        {
+            rc->_source = get();
+        }
+
+        return rc;
+    }
+
+    bool LazyTalkgroup::isDecoded() const
+    {
+        return (std::atomic_load(&_tg) != nullptr);
+    }
+
+    LazyTalkgroup::TalkgroupPtr LazyTalkgroup::get() const
+    {
+        TalkgroupPtr rc = std::atomic_load(&_tg);
+        if(rc)
+        {
+            return rc;
+        }
+
+        std::lock_guard<std::mutex> lck(_decodeLock);
+
+        // Someone may have beaten us to it
+        rc = std::atomic_load(&_tg);
+        if(!rc)
+        {
+            rc = decode();
+            std::atomic_store(&_tg, rc);
+        }
+
+        return rc;
+    }
+
+    void LazyTalkgroup::appendJson(std::string& out) const
+    {
+        get()->appendJson(out);
+    }
+
+    size_t LazyTalkgroup::footprint() const
+    {
+        TalkgroupPtr tg = std::atomic_load(&_tg);
+        if(!tg)
+        {
+            return (isEncoded() ? _length : sizeof(DataModel::Talkgroup));
+        }
+
+        return (sizeof(DataModel::Talkgroup) + (tg->cachedJson ? tg->cachedJson->size() : 0));
+    }
+
+    bool LazyTalkgroup::sameContent(const LazyTalkgroup& other) const
+    {
+        if(isEncoded() && other.isEncoded())
+        {
+            return (_isCbor == other._isCbor &&
+                    _length == other._length &&
+                    memcmp(_body->data() + _offset, other._body->data() + other._offset, _length) == 0);
+        }
+
+        // Only happens when a device's configuration crosses the threshold for lazy decoding
+        return contentMatches(*get(), *other.get());
+    }
+
+    void LazyTalkgroup::getStats(Stats_t& stats)
+    {
+        stats._encoded = m_encoded;
+        stats._decoded = m_decoded;
+        stats._failed = m_failed;
+    }
+
+    LazyTalkgroup::TalkgroupPtr LazyTalkgroup::decode() const
+    {
+        std::shared_ptr<DataModel::Talkgroup> tg = std::make_shared<DataModel::Talkgroup>();
+
+        if(_source)
+        {
+            *tg = *_source;
+        }
+        else
+        {
+            const char *p = (_body->data() + _offset);
+
+            try
+            {
+                nlohmann::json j = (_isCbor ? nlohmann::json::from_cbor(p, p + _length) : nlohmann::json::parse(p, p + _length));
+                DataModel::fieldsFromJson(j, *tg);
+                m_decoded++;
+            }
+            catch(...)
+            {
+                // The scan checked the encoding as strictly as the parser so this is little more than running out
+                // of memory - the scan found the id so at least that much is known
+                tg->clear();
+                tg->id = _id;
+                m_failed++;
+
+                Core::getLogger()->e(TAG, "cannot decode talkgroup '%s' from %s", _id.c_str(), _deviceKey.c_str());
+            }
+        }
+
+        tg->deviceKey = _deviceKey;
+        tg->cacheJson();
+
+        return tg;
+    }
+
+    size_t LazyTalkgroup::contentHash(const DataModel::Talkgroup& tg)
+    {
+        ContentHasher h(tg);
+        DataModel::Talkgroup::describe(h);
+        return h.result();
+    }
+
+    bool LazyTalkgroup::contentMatches(const DataModel::Talkgroup& a, const DataModel::Talkgroup& b)
+    {
+        ContentMatcher m(a, b);
+        DataModel::Talkgroup::describe(m);
+        return m.result();
+    }
+}
@@ -0,0 +1,133 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef LAZYTALKGROUP_HPP
+#define LAZYTALKGROUP_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "MagellanDataModel.hpp"
+
+namespace Magellan
+{
+    /**
+     * @brief A talkgroup that may not have been decoded yet
+     *
+     * Talkgroups of large configurations are left where they are in the downloaded body (see ConfigurationScanner)
+     * with only their id and a hash of their encoding pulled out - which is all that diffing needs - and are decoded
+     * the first time something asks for them.  Talkgroups of smaller configurations arrive already decoded.  Either
+     * way, the decoded talkgroup carries the key of the device it came from and its cached serialization.
+     *
+     * Immutable apart from that one-time decode (which whichever thread gets there first does) so these are shared
+     * freely between configurations, snapshots, the change journal and pending notifications.  An encoded talkgroup
+     * keeps the body it's in alive.
+     **/
+    class LazyTalkgroup
+    {
+    public:
+        typedef std::shared_ptr<const DataModel::Talkgroup> TalkgroupPtr;
+        typedef std::shared_ptr<const LazyTalkgroup> Ptr;
+        typedef std::shared_ptr<const std::string> BodyPtr;
+
+        /** @brief Counters reported by getStats() **/
+        typedef struct _Stats_t
+        {
+            uint64_t                        _encoded;
+            uint64_t                        _decoded;
+            uint64_t                        _failed;
+        } Stats_t;
+
+        /** @brief Use the factories below **/
+        LazyTalkgroup();
+        virtual ~LazyTalkgroup();
+
+        /** @brief Wraps a talkgroup that's already been decoded (and stamped with its device key) **/
+        static Ptr fromTalkgroup(const TalkgroupPtr& tg);
+
+        /** @brief Refers to a talkgroup encoded in length bytes at offset in a body **/
+        static Ptr fromEncoding(const std::string& id, const std::string& deviceKey, const BodyPtr& body, size_t offset, size_t length, bool isCbor);
+
+        /** @brief The same talkgroup on behalf of another device **/
+        Ptr forDevice(const std::string& deviceKey) const;
+
+        inline const std::string& id() const
+        {
+            return _id;
+        }
+
+        inline const std::string& deviceKey() const
+        {
+            return _deviceKey;
+        }
+
+        /** @brief Hash of the content - encoded and decoded talkgroups hash differently **/
+        inline size_t hash() const
+        {
+            return _hash;
+        }
+
+        /** @brief True if the talkgroup is held as an encoding **/
+        inline bool isEncoded() const
+        {
+            return (_body != nullptr);
+        }
+
+        /** @brief True if get() has nothing left to do **/
+        bool isDecoded() const;
+
+        /** @brief The talkgroup, decoding it if this is the first time it's been asked for **/
+        TalkgroupPtr get() const;
+
+        /** @brief Appends the compact serialization of the talkgroup **/
+        void appendJson(std::string& out) const;
+
+        /**
+         * @brief Estimate of the memory the talkgroup holds
+         *
+         * The encoding's length while encoded (the body it's in is shared) - once decoded, the talkgroup itself
+         * plus its serialization, which stands in for the strings it's made of.
+         **/
+        size_t footprint() const;
+
+        /** @brief True if the talkgroups are the same whichever devices they're from **/
+        bool sameContent(const LazyTalkgroup& other) const;
+
+        /** @brief Retrieves the counters **/
+        static void getStats(Stats_t& stats);
+
+    private:
+        std::string                         _id;
+        std::string                         _deviceKey;
+        size_t                              _hash;
+
+        // Where an encoded talkgroup is
+        BodyPtr                             _body;
+        size_t                              _offset;
+        size_t                              _length;
+        bool                                _isCbor;
+
+        // A decoded talkgroup taken on for another device is copied when first asked for
+        TalkgroupPtr                        _source;
+
+        // Read without the lock (atomically) - the lock only serializes decoding
+        mutable TalkgroupPtr                _tg;
+        mutable std::mutex                  _decodeLock;
+
+        TalkgroupPtr decode() const;
+
+        static size_t contentHash(const DataModel::Talkgroup& tg);
+        static bool contentMatches(const DataModel::Talkgroup& a, const DataModel::Talkgroup& b);
+
+        static std::atomic<uint64_t>        m_encoded;
+        static std::atomic<uint64_t>        m_decoded;
+        static std::atomic<uint64_t>        m_failed;
+    };
+}
+
+#endif
@@ -7,6 +7,7 @@
 #include <map>
 #include <string>
 #include <string.h>
+#include <stdlib.h>
 #include <atomic>
 
 #include "MagellanApi.h"
@@ -90,3 +91,130 @@ MAGELLAN_API void magellanSetTalkgroupCallbacks(PFN_MAGELLAN_ON_NEW_TALKGROUPS p
                                           pfnOnRemovedTalkgroups,
                                           userData);
 }
+
+MAGELLAN_API void magellanSetTalkgroupViewCallbacks(PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnNewTalkgroupViews,
+                            PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnModifiedTalkgroupViews,
+                            PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnRemovedTalkgroupViews,
+                            const void *userData)
+{
+    Magellan::Core::setTalkgroupViewCallbacks(pfnOnNewTalkgroupViews,
+                                              pfnOnModifiedTalkgroupViews,
+                                              pfnOnRemovedTalkgroupViews,
+                                              userData);
+}
+
+MAGELLAN_API int magellanSubscribeTalkgroups(const char * _Nullable filterJson,
+                            PFN_MAGELLAN_ON_NEW_TALKGROUPS pfnOnNewTalkgroups,
+                            PFN_MAGELLAN_ON_MODIFIED_TALKGROUPS pfnOnModifiedTalkgroups,
+                            PFN_MAGELLAN_ON_REMOVED_TALKGROUPS pfnOnRemovedTalkgroups,
+                            const void *userData,
+                            MagellanToken_t * _Nonnull pToken)
+{
+    return Magellan::Core::subscribe(filterJson,
+                                     pfnOnNewTalkgroups,
+                                     pfnOnModifiedTalkgroups,
+                                     pfnOnRemovedTalkgroups,
+                                     userData,
+                                     pToken);
+}
+
+MAGELLAN_API int magellanUnsubscribeTalkgroups(MagellanToken_t token)
+{
+    return Magellan::Core::unsubscribe(token);
+}
+
+static int returnString(int rc, const std::string& s, char **pJson)
+{
+    if(rc == MAGELLAN_RESULT_OK)
+    {
+        *pJson = (char*)malloc(s.size() + 1);
+        if(*pJson == nullptr)
+        {
+            return MAGELLAN_RESULT_GENERAL_FAILURE;
+        }
+
+        memcpy(*pJson, s.c_str(), s.size() + 1);
+    }
+
+    return rc;
+}
+
+MAGELLAN_API int magellanGetTalkgroup(const char * _Nonnull id, char * _Nullable * _Nonnull pJson)
+{
+    if(id == nullptr || pJson == nullptr)
+    {
+        return MAGELLAN_RESULT_INVALID_PARAMETERS;
+    }
+
+    *pJson = nullptr;
+
+    std::string json;
+    return returnString(Magellan::Core::getTalkgroup(id, json), json, pJson);
+}
+
+MAGELLAN_API int magellanQueryTalkgroups(const char * _Nullable filterJson, char * _Nullable * _Nonnull pJson)
+{
+    if(pJson == nullptr)
+    {
+        return MAGELLAN_RESULT_INVALID_PARAMETERS;
+    }
+
+    *pJson = nullptr;
+
+    std::string json;
+    return returnString(Magellan::Core::queryTalkgroups(filterJson, json), json, pJson);
+}
+
+MAGELLAN_API void magellanFreeString(char * _Nullable s)
+{
+    free(s);
+}
+
+MAGELLAN_API int magellanGetDevices(char * _Nullable * _Nonnull pJson)
+{
+    if(pJson == nullptr)
+    {
+        return MAGELLAN_RESULT_INVALID_PARAMETERS;
+    }
+
+    *pJson = nullptr;
+
+    std::string json;
+    return returnString(Magellan::Core::getDevices(json), json, pJson);
+}
+
+MAGELLAN_API int magellanGetChangesSince(uint64_t seq, char * _Nullable * _Nonnull pJson)
+{
+    if(pJson == nullptr)
+    {
+        return MAGELLAN_RESULT_INVALID_PARAMETERS;
+    }
+
+    *pJson = nullptr;
+
+    std::string json;
+    return returnString(Magellan::Core::getChangesSince(seq, json), json, pJson);
+}
+
+MAGELLAN_API int magellanGetStats(char * _Nullable * _Nonnull pJson)
+{
+    if(pJson == nullptr)
+    {
+        return MAGELLAN_RESULT_INVALID_PARAMETERS;
+    }
+
+    *pJson = nullptr;
+
+    std::string json;
+    return returnString(Magellan::Core::getStats(json), json, pJson);
+}
+
+MAGELLAN_API int magellanGetSnapshotVersion(uint64_t * _Nonnull pVersion)
+{
+    if(pVersion == nullptr)
+    {
+        return MAGELLAN_RESULT_INVALID_PARAMETERS;
+    }
+
+    return Magellan::Core::getSnapshotVersion(pVersion);
+}
@@ -136,6 +136,10 @@ MAGELLAN_API int magellanResumeDiscovery(MagellanToken_t token);
  * @param pfnOnRemovedTalkgroups The function to call when previously discovered talkgroups have been removed.
  * @param userData Application-defined user data to pass when calling the callbacks.
  * 
+ * When the notifications.modifiedDeltas configuration option is set, modified talkgroups are not delivered in full.  Instead
+ * each element is {"id":"...", "deviceKey":"...", "changeMask":n, "patch":[...]} where patch is an RFC 6902 JSON Patch
+ * against the version previously delivered and changeMask is made up of the talkgroupChangeMask bits.
+ * 
  * @return MAGELLAN_RESULT_OK if successful.
 */
 MAGELLAN_API void magellanSetTalkgroupCallbacks(PFN_MAGELLAN_ON_NEW_TALKGROUPS pfnOnNewTalkgroups,
@@ -143,6 +147,184 @@ MAGELLAN_API void magellanSetTalkgroupCallbacks(PFN_MAGELLAN_ON_NEW_TALKGROUPS p
                             PFN_MAGELLAN_ON_REMOVED_TALKGROUPS pfnOnRemovedTalkgroups,
                             const void *userData);
 
+/**
+ * @brief [SYNC] Set view-based callbacks for discovery.
+ *
+ * These callbacks are an alternative (or addition) to those set by magellanSetTalkgroupCallbacks().  Rather than
+ * JSON they receive arrays of flat, read-only talkgroup views whose strings live in a single arena, removing
+ * the serialize/parse round trip for high-rate consumers.  The view set is only valid for the duration of the
+ * callback - copy anything that needs to be kept.  Views passed for removals only carry the talkgroup id.
+ *
+ * @param pfnOnNewTalkgroupViews The function to call when new talkgroups are discovered.
+ * @param pfnOnModifiedTalkgroupViews The function to call when configuration has changed for previously discovered talkgroups.
+ * @param pfnOnRemovedTalkgroupViews The function to call when previously discovered talkgroups have been removed.
+ * @param userData Application-defined user data to pass when calling the callbacks.
+ * 
+ * @see magellanSetTalkgroupCallbacks()
+*/
+MAGELLAN_API void magellanSetTalkgroupViewCallbacks(PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnNewTalkgroupViews,
+                            PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnModifiedTalkgroupViews,
+                            PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnRemovedTalkgroupViews,
+                            const void *userData);
+
+/**
+ * @brief [ASYNC] Adds a filtered subscriber for talkgroup events.
+ *
+ * Any number of subscribers may be registered, each with its own callbacks and a TalkgroupSubscription filter
+ * - e.g. {"types":[1,3], "deviceKey":"...", "namePrefix":"OPS-", "securityLevel":2}.  Members that are absent
+ * match everything.  A subscriber only receives the talkgroups its filter matches and is not called at all
+ * for batches in which nothing matches.  A subscriber added after discovery has started can catch up on
+ * what it missed with magellanGetChangesSince().
+ *
+ * @param filterJson The TalkgroupSubscription JSON, or null for all talkgroups.
+ * @param pfnOnNewTalkgroups The function to call when new talkgroups are discovered.
+ * @param pfnOnModifiedTalkgroups The function to call when configuration has changed for previously discovered talkgroups.
+ * @param pfnOnRemovedTalkgroups The function to call when previously discovered talkgroups have been removed.
+ * @param userData Application-defined user data to pass when calling the callbacks.
+ * @param pToken Pointer to receive the token identifying the subscriber.
+ * 
+ * @return MAGELLAN_RESULT_OK if successful.
+ * @see magellanUnsubscribeTalkgroups(), magellanSetTalkgroupCallbacks()
+*/
+MAGELLAN_API int magellanSubscribeTalkgroups(const char * _Nullable filterJson,
+                            PFN_MAGELLAN_ON_NEW_TALKGROUPS pfnOnNewTalkgroups,
+                            PFN_MAGELLAN_ON_MODIFIED_TALKGROUPS pfnOnModifiedTalkgroups,
+                            PFN_MAGELLAN_ON_REMOVED_TALKGROUPS pfnOnRemovedTalkgroups,
+                            const void *userData,
+                            MagellanToken_t * _Nonnull pToken);
+
+/**
+ * @brief [ASYNC] Removes a subscriber added with magellanSubscribeTalkgroups().
+ *
+ * @param token The token returned by magellanSubscribeTalkgroups().
+ * 
+ * @return MAGELLAN_RESULT_OK if successful.
+ * @see magellanSubscribeTalkgroups()
+*/
+MAGELLAN_API int magellanUnsubscribeTalkgroups(MagellanToken_t token);
+
+/**
+ * @brief [SYNC] Retrieves a talkgroup from the library's registry.
+ *
+ * The registry holds every talkgroup currently known across all discovered devices, removing
+ * the need for applications to mirror the talkgroup callbacks.
+ * A talkgroup served by several devices is returned as held for any one of them.
+ *
+ * @param id The talkgroup ID.
+ * @param pJson Pointer to receive the talkgroup JSON.  Release with magellanFreeString().
+ * 
+ * @return MAGELLAN_RESULT_OK if successful, MAGELLAN_RESULT_NOT_FOUND if the talkgroup is not known.
+ * @see magellanQueryTalkgroups(), magellanFreeString()
+*/
+MAGELLAN_API int magellanGetTalkgroup(const char * _Nonnull id, char * _Nullable * _Nonnull pJson);
+
+/**
+ * @brief [SYNC] Queries the library's talkgroup registry.
+ *
+ * The filter is a TalkgroupQuery JSON object - e.g. {"deviceKey":"...", "type":1, "address":"239.1.1.1",
+ * "securityLevel":2}.  Members that are absent match everything.  A null or empty filter returns all talkgroups.
+ * A talkgroup served by several devices appears once for each of them (each with its own deviceKey).
+ *
+ * @param filterJson Optional filter.
+ * @param pJson Pointer to receive a JSON array of matching talkgroups.  Release with magellanFreeString().
+ * 
+ * @return MAGELLAN_RESULT_OK if successful.
+ * @see magellanGetTalkgroup(), magellanFreeString()
+*/
+MAGELLAN_API int magellanQueryTalkgroups(const char * _Nullable filterJson, char * _Nullable * _Nonnull pJson);
+
+/**
+ * @brief [SYNC] Releases a string returned by the library.
+ *
+ * @param s The string to release.
+*/
+MAGELLAN_API void magellanFreeString(char * _Nullable s);
+
+/**
+ * @brief [SYNC] Retrieves the devices currently known to the library.
+ *
+ * The result is a JSON object containing the snapshot version the information was taken from and
+ * an array of devices - e.g. {"snapshotVersion":12, "devices":[{"deviceKey":"...", "url":"...", "version":3,
+ * "wireBytes":812, "bodyBytes":4096, "heldBytes":2900, "rejectedBodies":0}]}.  wireBytes is the configuration data
+ * received as transferred (compressed if the device chose to) and bodyBytes is the same data once decoded, both
+ * totalled across fetches.  heldBytes estimates the memory taken by the device's current configuration and
+ * rejectedBodies counts the configurations it served that broke the limits set in the restLink configuration.
+ *
+ * @param pJson Pointer to receive the JSON.  Release with magellanFreeString().
+ * 
+ * @return MAGELLAN_RESULT_OK if successful.
+ * @see magellanGetSnapshotVersion(), magellanFreeString()
+*/
+MAGELLAN_API int magellanGetDevices(char * _Nullable * _Nonnull pJson);
+
+/**
+ * @brief [SYNC] Retrieves the version of the library's discovered state.
+ *
+ * The version increases every time discovered devices or talkgroups change - including when only a
+ * device's statistics (such as wireBytes) move because a refetch returned the configuration already
+ * held.  A refetch that leaves everything as it was does not move the version.  Reading it takes
+ * no locks so applications may cheaply poll it (at frame rate for example) and only re-query
+ * when it has moved.
+ *
+ * @param pVersion Pointer to receive the version.
+ * 
+ * @return MAGELLAN_RESULT_OK if successful.
+ * @see magellanGetDevices(), magellanQueryTalkgroups()
+*/
+MAGELLAN_API int magellanGetSnapshotVersion(uint64_t * _Nonnull pVersion);
+
+/**
+ * @brief [SYNC] Retrieves the talkgroup changes made after a given sequence number.
+ *
+ * Every talkgroup addition, modification and removal is stamped with a sequence number and kept in a bounded
+ * journal.  A consumer that starts late, or reconnects, passes the last sequence it processed (0 to start) and
+ * receives either the changes since then:
+ *
+ * {"full":false, "sequence":120, "changes":[{"seq":119, "op":"add|modify|remove", "id":"...", "deviceKey":"...", "talkgroup":{...}}]}
+ *
+ * or, when the journal no longer reaches back that far, every current talkgroup:
+ *
+ * {"full":true, "sequence":120, "talkgroups":[...]}
+ *
+ * Either way "sequence" is the value to pass on the next call.
+ *
+ * @param seq The last sequence number processed.
+ * @param pJson Pointer to receive the JSON.  Release with magellanFreeString().
+ * 
+ * @return MAGELLAN_RESULT_OK if successful.
+ * @see magellanFreeString()
+*/
+MAGELLAN_API int magellanGetChangesSince(uint64_t seq, char * _Nullable * _Nonnull pJson);
+
+/**
+ * @brief [SYNC] Retrieves the library's operational statistics.
+ *
+ * The statistics are returned as a JSON object - e.g. {"callbacks":{"delivered":10, "dropped":0, "slow":1, ...},
+ * "downloads":{"fetches":4, "bytes":2890, "wireBytes":1120, "cborBodies":3, "jsonBodies":1, "decodeUs":410, ...},
+ * "content":{"talkgroups":12, "configurations":3, "lookups":60, "hits":45}, "strings":{"count":8, "bytes":960,
+ * "released":2}}.  "content" describes the configurations held for discovered devices - identical talkgroups and
+ * configurations are held once however many devices serve them.  "strings" describes the table of interned device
+ * and discoverer keys and talkgroup addresses - "released" counts those dropped once nothing referred to them.
+ * "parseArena" - e.g. {"allocations":52000, "bytes":2900000, "peakBytes":310000, "blocks":6, "resets":4} - counts
+ * the allocations made while decoding downloads that were served from the per-download arena rather than the heap
+ * ("blocks" is how many times the arena itself went to the heap).  "lazyTalkgroups" - e.g. {"encoded":6000,
+ * "decoded":40, "failed":0} - counts the talkgroups of large configurations (see lazyTalkgroupThreshold in the
+ * restLink configuration, and "lazyBodies" in "downloads") left encoded when downloaded, and how many of those have
+ * since been decoded because something needed them.
+ * "identicalBodies" in "downloads" counts fetches whose body was byte-for-byte the one last processed for that
+ * device - those go no further than being hashed.  "limits" - e.g. {"bodyBytes":1, "talkgroups":0, "rallypoints":0,
+ * "stringLength":0} - counts the downloads turned away for breaking each of the limits set in the restLink
+ * configuration (maxBodyBytes, maxTalkgroups, maxRallypointsPerTalkgroup and maxStringLength).  "memory" - e.g.
+ * {"heldBytes":5800, "devices":{"<deviceKey>":{"heldBytes":2900, "parseBytes":41000, "rejectedBodies":0}, ...}} -
+ * estimates what each device's configuration takes up and how much memory decoding its last body needed.
+ *
+ * @param pJson Pointer to receive the JSON.  Release with magellanFreeString().
+ * 
+ * @return MAGELLAN_RESULT_OK if successful.
+ * @see magellanFreeString()
+*/
+MAGELLAN_API int magellanGetStats(char * _Nullable * _Nonnull pJson);
+
 
 
 #ifdef __cplusplus
@@ -32,6 +32,8 @@ static const int MAGELLAN_RESULT_NOT_INITIALIZED = -2;
 static const int MAGELLAN_RESULT_ALREADY_INITIALIZED = -3;
 /** @brief An unspecified error has occurred */
 static const int MAGELLAN_RESULT_GENERAL_FAILURE = -4;
+/** @brief The requested item does not exist */
+static const int MAGELLAN_RESULT_NOT_FOUND = -5;
 /** @} */
 
 
@@ -97,4 +99,35 @@ static const int MAGELLAN_FILTER_IGNORE = 0;
 static const int MAGELLAN_FILTER_PROCEED = 1;
 /** @} */
 
+/** @addtogroup talkgroupChangeMask Magellan Talkgroup Change Mask
+ *
+ * Bits indicating which parts of a talkgroup changed in a modification.  Delivered in the
+ * "changeMask" of delta notifications and in the changeMask of talkgroup views.
+ *
+ *  @{
+ */
+/** @brief The name changed */
+static const uint32_t MAGELLAN_TG_CHANGE_NAME = 0x0001;
+/** @brief The type changed */
+static const uint32_t MAGELLAN_TG_CHANGE_TYPE = 0x0002;
+/** @brief The crypto password changed */
+static const uint32_t MAGELLAN_TG_CHANGE_CRYPTO = 0x0004;
+/** @brief Presence settings changed */
+static const uint32_t MAGELLAN_TG_CHANGE_PRESENCE = 0x0008;
+/** @brief The rallypoints changed */
+static const uint32_t MAGELLAN_TG_CHANGE_RALLYPOINTS = 0x0010;
+/** @brief The rx address changed */
+static const uint32_t MAGELLAN_TG_CHANGE_RX = 0x0020;
+/** @brief The tx address changed */
+static const uint32_t MAGELLAN_TG_CHANGE_TX = 0x0040;
+/** @brief Transmit audio settings changed */
+static const uint32_t MAGELLAN_TG_CHANGE_TXAUDIO = 0x0080;
+/** @brief Network options changed */
+static const uint32_t MAGELLAN_TG_CHANGE_NETWORK_OPTIONS = 0x0100;
+/** @brief Security settings changed */
+static const uint32_t MAGELLAN_TG_CHANGE_SECURITY = 0x0200;
+/** @brief Something else changed (or the previous version is unknown) */
+static const uint32_t MAGELLAN_TG_CHANGE_OTHER = 0x8000;
+/** @} */
+
 #endif
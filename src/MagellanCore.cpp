@@ -8,7 +8,9 @@
 #include <string>
 #include <string.h>
 #include <atomic>
+#include <memory>
 #include <inttypes.h>
+#include <algorithm>
 
 #if defined(WIN32)
     #define CURL_STATICLIB
@@ -29,6 +31,17 @@
 #endif
 
 #include "SsdpDiscoverer.hpp"
+#include "MdnsDiscoverer.hpp"
+#include "TalkgroupRegistry.hpp"
+#include "TalkgroupViewSet.hpp"
+#include "ChangeJournal.hpp"
+#include "ConfigurationCache.hpp"
+#include "ContentStore.hpp"
+#include "StringTable.hpp"
+#include "ParseArena.hpp"
+#include "ConfigurationScanner.hpp"
+#include "LazyTalkgroup.hpp"
+#include "ConfigurationLimits.hpp"
 
 namespace Magellan
 {
@@ -45,49 +58,264 @@ namespace Magellan
                     psComplete
                 } ProcessingState_t;
 
+                /** @brief One discoverer's path to the device **/
+                typedef struct _Route_t
+                {
+                    std::string         _url;
+                    unsigned long       _version;
+                } Route_t;
+
+                // Keyed by the (interned) discoverer key
+                typedef std::map<StringTable::Handle_t, Route_t> RouteMap_t;
+
                 DeviceTracker()
                 {          
                     _ps = psNone;
                     _nextCheckTs = 0;
                     _consecutiveErrors = 0;
+                    _advertisedVersion = 0;
+                    _refetchWanted = false;
+                    _fetchVersion = 0;
+                    _staleFetches = 0;
+                    _wireBytes = 0;
+                    _bodyBytes = 0;
+                    _bodyHash = 0;
+                    _heldBytes = 0;
+                    _parseBytes = 0;
+                    _rejectedBodies = 0;
+                    _provisional = false;
+                    _provisionalUntil = 0;
+                    _key = StringTable::NONE;
+                    _activeRoute = StringTable::NONE;
                 }
 
                 ~DeviceTracker()
                 {                
                 }
 
-                std::string             _key;
+                /** @brief The device key **/
+                const std::string& key() const;
+
+                /** @brief Version of the configuration we hold (0 if none) **/
+                unsigned long configVersion() const
+                {
+                    return (_cfg ? _cfg->_version : 0);
+                }
+
+                /** @brief Makes the next alternate route (if any) the one used for fetching **/
+                void rotateRoute()
+                {
+                    if(_routes.size() > 1)
+                    {
+                        RouteMap_t::iterator itr = _routes.upper_bound(_activeRoute);
+                        if(itr == _routes.end())
+                        {
+                            itr = _routes.begin();
+                        }
+
+                        _activeRoute = itr->first;
+                        _url = itr->second._url;
+                    }
+                }
+
+                /** @brief Recomputes the advertised version as the highest reported across all routes - true if it rose **/
+                bool updateAdvertisedVersion()
+                {
+                    unsigned long previous = _advertisedVersion;
+
+                    _advertisedVersion = 0;
+                    for(RouteMap_t::iterator itr = _routes.begin();
+                        itr != _routes.end();
+                        itr++)
+                    {
+                        if(itr->second._version > _advertisedVersion)
+                        {
+                            _advertisedVersion = itr->second._version;
+                        }
+                    }
+
+                    return (_advertisedVersion > previous);
+                }
+
+                StringTable::Handle_t   _key;
                 std::string             _url;
+                StringTable::Handle_t   _activeRoute;
+                RouteMap_t              _routes;
                 ProcessingState_t                     _ps;
-                DataModel::DeviceConfiguration        _cfg;
+                ContentStore::ConfigurationPtr        _cfg;
                 uint64_t                              _nextCheckTs;
                 unsigned long                         _consecutiveErrors;
+
+                // Highest configuration version advertised by any route
+                unsigned long                         _advertisedVersion;
+
+                // Set when the advertised version moves while a fetch is already in flight
+                bool                                  _refetchWanted;
+
+                // Advertised version the last fetch was started for - stays at a version that was given up on so
+                // that repeated advertisements of it don't start over
+                unsigned long                         _fetchVersion;
+
+                // Successful fetches in a row whose body was older than what's advertised
+                unsigned long                         _staleFetches;
+
+                // Configuration bytes received as transferred (possibly compressed) and once decoded
+                uint64_t                              _wireBytes;
+                uint64_t                              _bodyBytes;
+
+                // Hash of the last downloaded body that was processed (0 if the configuration held didn't come from one)
+                uint64_t                              _bodyHash;
+
+                // Estimate of what the configuration held takes up, what decoding the last body took, and how many
+                // bodies were turned away for breaking the configured limits
+                uint64_t                              _heldBytes;
+                uint64_t                              _parseBytes;
+                uint64_t                              _rejectedBodies;
+
+                // Presented from the cache at startup and not (yet) rediscovered
+                bool                                  _provisional;
+                uint64_t                              _provisionalUntil;
         };
 
-        typedef std::map<std::string, DeviceTracker> DeviceMap_t;
+        // Keyed by the (interned) device key
+        typedef std::map<StringTable::Handle_t, DeviceTracker> DeviceMap_t;
+
+        // Maps a discoverer key (one route) to the key of the device it leads to - both interned
+        typedef std::map<StringTable::Handle_t, StringTable::Handle_t> RouteIndex_t;
+
+        // A talkgroup change waiting to be delivered to the application
+        typedef struct _PendingChange_t
+        {
+            typedef enum
+            {
+                ckNew,
+                ckModified,
+                ckRemoved
+            } ChangeKind_t;
+
+            ChangeKind_t                                _kind;
+            ContentStore::TalkgroupPtr                  _tg;
+
+            // For modifications, the talkgroup as the application last saw it (if known)
+            ContentStore::TalkgroupPtr                  _prev;
+        } PendingChange_t;
+
+        // Keyed by device key + talkgroup id
+        typedef std::map<std::string, PendingChange_t> PendingChangeMap_t;
 
         static const char *TAG = "MagellanCore";
 
         static WorkQueue                                *m_mainWorkQueue = nullptr;
         static WorkQueue                                *m_downloadWorkQueue = nullptr;
+
+        // Application callbacks are delivered from here so a slow application can't hold up discovery
+        static WorkQueue                                *m_callbackWorkQueue = nullptr;
         static SimpleLogger                             m_simpleLogger;
         static TimerManager                             *m_timerManager = nullptr;
 
         static std::atomic<bool>                        m_initialized(false);
         static DeviceMap_t                              m_devices;
+        static RouteIndex_t                             m_routes;
+
+        // Device and discoverer keys (and the addresses the registry filters on) are long and endlessly repeated so
+        // they're only held here.  Each device and route holds a reference to its key, as does a download under way
+        // and every registry row, so what's held is only ever what's still in use.
+        static StringTable                              m_strings;
+
+        const std::string& DeviceTracker::key() const
+        {
+            return m_strings.get(_key);
+        }
+
+        // The published snapshot of discovered state.  Only the main work queue replaces it (always with a modified
+        // copy) while any thread may grab a reference to it without locking - see loadSnapshot()/publishSnapshot().
+        static std::shared_ptr<const TalkgroupRegistry> m_snapshot;
+        static uint64_t                                 m_snapshotVersion = 0;
+
+
+        // A consumer of talkgroup events
+        typedef struct _Subscriber_t
+        {
+            DataModel::TalkgroupSubscription        _filter;
+            PFN_MAGELLAN_ON_NEW_TALKGROUPS          _pfnOnNew;
+            PFN_MAGELLAN_ON_MODIFIED_TALKGROUPS     _pfnOnModified;
+            PFN_MAGELLAN_ON_REMOVED_TALKGROUPS      _pfnOnRemoved;
+            const void                              *_userData;
+        } Subscriber_t;
+
+        typedef std::map<uint64_t, Subscriber_t> SubscriberMap_t;
+
+        // The callbacks set with setTalkgroupCallbacks() are simply an unfiltered subscriber with this id
+        static const uint64_t                           LEGACY_SUBSCRIBER_ID = 0;
+
+        static SubscriberMap_t                          m_subscribers;
+        static std::atomic<uint64_t>                    m_nextSubscriberId(1);
+
+        static PFN_MAGELLAN_ON_TALKGROUP_VIEWS          m_pfnOnNewTalkgroupViews = nullptr;
+        static PFN_MAGELLAN_ON_TALKGROUP_VIEWS          m_pfnOnModifiedTalkgroupViews = nullptr;
+        static PFN_MAGELLAN_ON_TALKGROUP_VIEWS          m_pfnOnRemovedTalkgroupViews = nullptr;
+        static const void                               *m_pfOnTgViewUserData = nullptr;
+
+        static PendingChangeMap_t                       m_pendingChanges;
+
+        // Every change (before coalescing) is journaled for consumers catching up via getChangesSince()
+        static ChangeJournal                            m_journal;
+
+        // Counters reported by getStats()
+        typedef struct _CallbackStats_t
+        {
+            std::atomic<uint64_t>       _delivered;
+            std::atomic<uint64_t>       _dropped;
+            std::atomic<uint64_t>       _slow;
+            std::atomic<uint64_t>       _totalMs;
+            std::atomic<uint64_t>       _maxMs;
+        } CallbackStats_t;
 
+        static CallbackStats_t                          m_callbackStats;
 
-        static PFN_MAGELLAN_ON_NEW_TALKGROUPS           m_pfnOnNewTalkgroups = nullptr;
-        static PFN_MAGELLAN_ON_MODIFIED_TALKGROUPS      m_pfnOnModifiedTalkgroups = nullptr;             
-        static PFN_MAGELLAN_ON_REMOVED_TALKGROUPS       m_pfnOnRemovedTalkgroups = nullptr;
-        static const void                               *m_pfOnTgUserData = nullptr;
+        typedef struct _DownloadStats_t
+        {
+            std::atomic<uint64_t>       _fetches;
+            std::atomic<uint64_t>       _failures;
+            std::atomic<uint64_t>       _bytes;
+            std::atomic<uint64_t>       _wireBytes;
+            std::atomic<uint64_t>       _cborBodies;
+            std::atomic<uint64_t>       _jsonBodies;
+            std::atomic<uint64_t>       _lazyBodies;
+            std::atomic<uint64_t>       _identicalBodies;
+            std::atomic<uint64_t>       _decodeUs;
+
+            // Bodies turned away, by the limit they broke
+            std::atomic<uint64_t>       _overBodyBytes;
+            std::atomic<uint64_t>       _overTalkgroups;
+            std::atomic<uint64_t>       _overRallypoints;
+            std::atomic<uint64_t>       _overStringLength;
+        } DownloadStats_t;
+
+        static DownloadStats_t                          m_downloadStats;
+
+        // Last configuration from each device, persisted across restarts
+        static ConfigurationCache                       m_cache;
+
+        // Backs the parse trees of downloads - only used on the download work queue
+        static ParseArena                               m_parseArena;
+
+        // Configurations and talkgroups held by the device trackers, shared where the content is the same
+        static ContentStore                             m_contentStore;
 
         static uint64_t                                 m_tmrHouseKeeper = 0;
         static uint64_t                                 m_tmrUrlChecker = 0;
+        static uint64_t                                 m_tmrNotifier = 0;
 
         static DataModel::MagellanConfiguration         m_configuration;
 
-        void doUrlDownload(const char *url, const char *discovererKey);
+        void doUrlDownload(const char *url, StringTable::Handle_t deviceKey, uint64_t lastBodyHash);
+        bool useCachedConfiguration(DeviceTracker *dt);
+        void presentCachedDevices();
+        void notifyOfLostDevice(DeviceTracker *dt);
+        DeviceMap_t::iterator eraseDevice(DeviceMap_t::iterator itrDev);
+        void convergeOnAdvertisedVersion(const char *deviceKey, DeviceTracker *dt);
+        void flushTalkgroupChanges();
 
         uint64_t getNowMs()
         {
@@ -123,6 +351,88 @@ namespace Magellan
         void performHousekeeping()
         {
             //getLogger()->d(TAG, "performHousekeeping");
+
+            // Cached devices that haven't turned up within their grace period are dropped
+            uint64_t now = getNowMs();
+
+            DeviceMap_t::iterator itr = m_devices.begin();
+            while(itr != m_devices.end())
+            {
+                if(itr->second._provisional && itr->second._provisionalUntil <= now)
+                {
+                    getLogger()->i(TAG, "cached device %s was not rediscovered - removing", itr->second.key().c_str());
+                    notifyOfLostDevice(&itr->second);
+
+                    // Otherwise it'd be presented (and withdrawn) again at every startup
+                    if(m_cache.isOpen())
+                    {
+                        m_cache.remove(itr->second.key());
+                    }
+
+                    itr = eraseDevice(itr);
+                }
+                else
+                {
+                    itr++;
+                }
+            }
+
+            // Content that departed devices (or superseded configurations) no longer reference
+            m_contentStore.purge();
+        }
+
+        void startFetch(DeviceTracker *dt)
+        {
+            dt->_ps = DeviceTracker::psInProgress;
+            dt->_nextCheckTs = 0;
+            dt->_refetchWanted = false;
+            dt->_fetchVersion = dt->_advertisedVersion;
+
+            // The download holds on to the key until its outcome has been dealt with - the device may be gone by then
+            std::string l_url = dt->_url;
+            StringTable::Handle_t l_key = dt->_key;
+            uint64_t l_bodyHash = dt->_bodyHash;
+            m_strings.addRef(l_key);
+            m_downloadWorkQueue->submit(([l_url, l_key, l_bodyHash]()
+            {            
+                doUrlDownload(l_url.c_str(), l_key, l_bodyHash);
+            }));
+        }
+
+        // Called for every report of the device - most just repeat what's already known
+        void requestFetch(DeviceTracker *dt, bool versionRose)
+        {
+            if(dt->_ps == DeviceTracker::psInProgress)
+            {
+                // Only a version newer than the one being fetched needs a follow-up
+                if(!versionRose || dt->_advertisedVersion <= dt->_fetchVersion)
+                {
+                    return;
+                }
+
+                // Any number of bumps during a fetch collapse into a single follow-up
+                if(!dt->_refetchWanted)
+                {
+                    getLogger()->d(TAG, "%s advertised version %lu while a fetch is in progress - will refetch", dt->key().c_str(), dt->_advertisedVersion);
+                }
+                dt->_refetchWanted = true;
+            }
+            else if(dt->_ps == DeviceTracker::psPending)
+            {
+                // A retry is already scheduled and will pick up whatever is current then
+            }
+            else if(dt->_ps == DeviceTracker::psNone ||
+                    (dt->configVersion() != dt->_advertisedVersion && dt->_advertisedVersion != dt->_fetchVersion))
+            {
+                if(useCachedConfiguration(dt))
+                {
+                    return;
+                }
+
+                getLogger()->d(TAG, "%s advertised version %lu (have %lu) - querying", dt->key().c_str(), dt->_advertisedVersion, (unsigned long) dt->configVersion());
+                dt->_staleFetches = 0;
+                startFetch(dt);
+            }
         }
 
         void performUrlChecking()
@@ -140,15 +450,7 @@ namespace Magellan
                 {
                     if(dt->_nextCheckTs > 0 && dt->_nextCheckTs <= now)
                     {
-                        dt->_ps = DeviceTracker::psInProgress;
-                        dt->_nextCheckTs = 0;
-
-                        std::string l_url = dt->_url.c_str();
-                        std::string l_key = dt->_key.c_str();
-                        m_downloadWorkQueue->submit(([l_url, l_key]()
-                        {            
-                            doUrlDownload(l_url.c_str(), l_key.c_str());
-                        }));
+                        startFetch(dt);
                     }
                 }
             }
@@ -174,6 +476,16 @@ namespace Magellan
             return true;
         }
 
+        bool tmrCbNotifier(uint64_t hnd, const void *ctx)
+        {
+            m_mainWorkQueue->submit(([]()
+            {
+                flushTalkgroupChanges();
+            }));
+
+            return true;
+        }
+
         void initCrypto()
         {
             /*
@@ -198,6 +510,7 @@ namespace Magellan
 
             m_mainWorkQueue = new WorkQueue();
             m_downloadWorkQueue = new WorkQueue();
+            m_callbackWorkQueue = new WorkQueue();
             m_timerManager = new TimerManager();
 
             getLogger()->d(TAG, "magellanInitialize %s", (configuration == nullptr ? "" : configuration));
@@ -217,9 +530,39 @@ namespace Magellan
 
             initCrypto();
 
+            m_callbackStats._delivered = 0;
+            m_callbackStats._dropped = 0;
+            m_callbackStats._slow = 0;
+            m_callbackStats._totalMs = 0;
+            m_callbackStats._maxMs = 0;
+
+            m_downloadStats._fetches = 0;
+            m_downloadStats._failures = 0;
+            m_downloadStats._bytes = 0;
+            m_downloadStats._wireBytes = 0;
+            m_downloadStats._cborBodies = 0;
+            m_downloadStats._jsonBodies = 0;
+            m_downloadStats._lazyBodies = 0;
+            m_downloadStats._identicalBodies = 0;
+            m_downloadStats._decodeUs = 0;
+            m_downloadStats._overBodyBytes = 0;
+            m_downloadStats._overTalkgroups = 0;
+            m_downloadStats._overRallypoints = 0;
+            m_downloadStats._overStringLength = 0;
+
+            m_callbackWorkQueue->setMaxDepth(m_configuration.notifications.maxQueuedCallbacks);
+
+            m_journal.reset();
+            m_journal.setCapacity(m_configuration.notifications.journalSize);
+
+            if(!m_configuration.cache.directory.empty())
+            {
+                m_cache.open(m_configuration.cache.directory);
+            }
 
             m_mainWorkQueue->start();
             m_downloadWorkQueue->start();
+            m_callbackWorkQueue->start();
             m_timerManager->start();
 
             curl_global_init(CURL_GLOBAL_ALL);
@@ -227,6 +570,20 @@ namespace Magellan
             m_tmrHouseKeeper = m_timerManager->setTimer(tmrCbHouseKeeper, nullptr, m_configuration.houseKeeperIntervalMs, true);
             m_tmrUrlChecker = m_timerManager->setTimer(tmrCbUrlChecker, nullptr, m_configuration.restLink.urlCheckerIntervalMs, true);
 
+            // Coalesced talkgroup changes go out each time the window closes
+            if(m_configuration.notifications.coalesceWindowMs > 0)
+            {
+                m_tmrNotifier = m_timerManager->setTimer(tmrCbNotifier, nullptr, m_configuration.notifications.coalesceWindowMs, true);
+            }
+
+            if(m_cache.isOpen() && m_configuration.cache.provisionalAtStartup)
+            {
+                m_mainWorkQueue->submit(([]()
+                {
+                    presentCachedDevices();
+                }));
+            }
+
             return rc;
         }
 
@@ -247,213 +604,886 @@ namespace Magellan
             m_timerManager->cancelTimer(m_tmrUrlChecker);
             m_tmrUrlChecker = 0;
 
+            if(m_tmrNotifier != 0)
+            {
+                m_timerManager->cancelTimer(m_tmrNotifier);
+                m_tmrNotifier = 0;
+            }
+
             m_timerManager->stop();
 
             curl_global_cleanup();
 
             m_downloadWorkQueue->stop();
             m_mainWorkQueue->stop();
+            m_callbackWorkQueue->stop();
 
             deinitCrypto();
 
             delete m_mainWorkQueue;
             delete m_downloadWorkQueue;
+            delete m_callbackWorkQueue;
             delete m_timerManager;
 
             m_mainWorkQueue = nullptr;
             m_downloadWorkQueue = nullptr;
+            m_callbackWorkQueue = nullptr;
             m_timerManager = nullptr;
 
+            std::atomic_store(&m_snapshot, std::shared_ptr<const TalkgroupRegistry>());
+            m_pendingChanges.clear();
+            m_subscribers.clear();
+            m_cache.close();
+            m_contentStore.clear();
+
             m_initialized = false;
             
             return rc;
         }
 
-        DataModel::Talkgroup *getTalkgroup(const char *id, std::vector<DataModel::Talkgroup>& v)
+        std::shared_ptr<const TalkgroupRegistry> loadSnapshot()
         {
-            for(std::vector<DataModel::Talkgroup>::iterator itrSearch = v.begin();
-                itrSearch != v.end();
-                itrSearch++)
+            return std::atomic_load(&m_snapshot);
+        }
+
+        // Returns a modifiable copy of the current snapshot (main work queue only)
+        std::shared_ptr<TalkgroupRegistry> cloneSnapshot()
+        {
+            std::shared_ptr<const TalkgroupRegistry> current = loadSnapshot();
+            if(current)
             {
-                if(itrSearch->id.compare(id) == 0)
-                {
-                    return &(*itrSearch);
-                }
+                return std::make_shared<TalkgroupRegistry>(*current);
             }
 
-            return nullptr;
+            return std::make_shared<TalkgroupRegistry>(m_strings);
         }
 
-        void notifyOfLostDevice(DeviceTracker *dt)
+        void publishSnapshot(std::shared_ptr<TalkgroupRegistry>& snap)
+        {
+            m_snapshotVersion++;
+            snap->setVersion(m_snapshotVersion);
+
+            // Changes are journaled before publishing so everything up to this sequence is reflected in the snapshot
+            snap->setSequence(m_journal.lastSequence());
+            std::atomic_store(&m_snapshot, std::shared_ptr<const TalkgroupRegistry>(snap));
+        }
+
+        // Runs an application callback on the callback queue, keeping track of how long it takes
+        void deliver(const char *name, std::function<void()> fn)
         {
-            if(!dt->_cfg.talkgroups.empty() && m_pfnOnRemovedTalkgroups != nullptr)
+            std::string l_name = name;
+
+            bool submitted = m_callbackWorkQueue->submit(([l_name, fn]()
             {
-                nlohmann::json idArray = nlohmann::json::array();
+                uint64_t started = getNowMs();
+                fn();
+                uint64_t took = (getNowMs() - started);
+
+                m_callbackStats._delivered++;
+                m_callbackStats._totalMs += took;
 
-                for( std::vector<DataModel::Talkgroup>::iterator itrTg = dt->_cfg.talkgroups.begin();
-                    itrTg != dt->_cfg.talkgroups.end();
-                    itrTg++)
+                uint64_t maxMs = m_callbackStats._maxMs;
+                while(took > maxMs && !m_callbackStats._maxMs.compare_exchange_weak(maxMs, took))
                 {
-                    getLogger()->d(TAG, "notify tg '%s' has gone", itrTg->id.c_str());
-                    idArray.push_back(itrTg->id.c_str());
                 }
 
-                m_pfnOnRemovedTalkgroups(idArray.dump().c_str(), m_pfOnTgUserData);
+                if(took > m_configuration.notifications.slowCallbackWarningMs)
+                {
+                    m_callbackStats._slow++;
+                    getLogger()->w(TAG, "application callback %s took %" PRIu64 " milliseconds", l_name.c_str(), took);
+                }
+            }));
+
+            if(!submitted)
+            {
+                m_callbackStats._dropped++;
+                getLogger()->e(TAG, "callback queue full - dropped %s", name);
             }
         }
 
+        void deliverJson(const char *name, void (*pfn)(const char *, const void *), const std::string& json, const void *userData)
+        {
+            deliver(name, ([pfn, json, userData]()
+            {
+                pfn(json.c_str(), userData);
+            }));
+        }
 
-        void processDeviceConfiguration(const char *discovererKey, DeviceTracker *dt, DataModel::DeviceConfiguration *dc, bool encounteredError)
+        void deliverViews(const char *name, PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfn, std::shared_ptr<TalkgroupViewSet> views, const void *userData)
         {
-            // Did we encounter an error?
-            if(encounteredError)
+            deliver(name, ([pfn, views, userData]()
             {
-                dt->_consecutiveErrors++;
+                pfn(views->get(), userData);
+            }));
+        }
 
-                if(dt->_consecutiveErrors >= m_configuration.restLink.maxUrlConsecutiveErrors)
+        uint32_t changeMaskForMember(const std::string& member)
+        {
+            static const struct
+            {
+                const char  *member;
+                uint32_t    mask;
+            } MEMBER_MASKS[] = 
+            {
+                {"name", MAGELLAN_TG_CHANGE_NAME},
+                {"type", MAGELLAN_TG_CHANGE_TYPE},
+                {"cryptoPassword", MAGELLAN_TG_CHANGE_CRYPTO},
+                {"presence", MAGELLAN_TG_CHANGE_PRESENCE},
+                {"rallypoints", MAGELLAN_TG_CHANGE_RALLYPOINTS},
+                {"rx", MAGELLAN_TG_CHANGE_RX},
+                {"tx", MAGELLAN_TG_CHANGE_TX},
+                {"txAudio", MAGELLAN_TG_CHANGE_TXAUDIO},
+                {"networkOptions", MAGELLAN_TG_CHANGE_NETWORK_OPTIONS},
+                {"security", MAGELLAN_TG_CHANGE_SECURITY}
+            };
+
+            for(size_t x = 0; x < sizeof(MEMBER_MASKS) / sizeof(MEMBER_MASKS[0]); x++)
+            {
+                if(member.compare(MEMBER_MASKS[x].member) == 0)
                 {
-                    if(m_configuration.restLink.abandonUrlsAfterConsecutiveErrors)
-                    {
-                        getLogger()->e(TAG, "too many consecutive errors on %s - abandoning", discovererKey);
-                        notifyOfLostDevice(dt);
-                        m_devices.erase(discovererKey);
+                    return MEMBER_MASKS[x].mask;
+                }
+            }
 
-                        // NOTE: Early return here
-                        return;
-                    }
+            return MAGELLAN_TG_CHANGE_OTHER;
+        }
 
-                    // Stay at ceiling
-                    dt->_consecutiveErrors = m_configuration.restLink.maxUrlConsecutiveErrors;
+        // Produces an RFC 6902 patch from the previous version of a modified talkgroup and returns the mask of
+        // what changed (0 if nothing did)
+        uint32_t computeTalkgroupDelta(const PendingChange_t& pc, nlohmann::json& patch)
+        {
+            nlohmann::json current = *pc._tg->get();
+
+            if(!pc._prev)
+            {
+                nlohmann::json op;
+                op["op"] = "replace";
+                op["path"] = "";
+                op["value"] = current;
+
+                patch = nlohmann::json::array();
+                patch.push_back(op);
+
+                return MAGELLAN_TG_CHANGE_OTHER;
+            }
+
+            nlohmann::json previous = *pc._prev->get();
+            patch = nlohmann::json::diff(previous, current);
+
+            uint32_t mask = 0;
+            for(nlohmann::json::iterator itr = patch.begin();
+                itr != patch.end();
+                itr++)
+            {
+                // Paths look like "/member/..." - the first segment tells us which part changed
+                std::string path = (*itr)["path"];
+                if(path.size() < 2)
+                {
+                    mask |= MAGELLAN_TG_CHANGE_OTHER;
+                    continue;
                 }
 
-                uint64_t now = getNowMs();
-                uint64_t rndAmount = (rand() % (dt->_consecutiveErrors * m_configuration.restLink.urlRetryIntervalMs));
+                size_t end = path.find('/', 1);
+                mask |= changeMaskForMember(path.substr(1, (end == std::string::npos ? std::string::npos : end - 1)));
+            }
 
-                dt->_nextCheckTs = ((now + (dt->_consecutiveErrors * 1000)) + rndAmount);
-                dt->_ps = DeviceTracker::psPending;
-                getLogger()->e(TAG, "scheduled next check of %s in %" PRIu64 " milliseconds", discovererKey, (dt->_nextCheckTs - now));
-                
-                // NOTE: Early return here
-                return;
+            return mask;
+        }
+
+        // Adds an already-serialized element to a JSON array being built (the caller closes it)
+        void appendToJsonArray(std::string& arr, const std::string& element)
+        {
+            arr.append(arr.empty() ? "[" : ",");
+            arr.append(element);
+        }
+
+        // As above but for a talkgroup, which is copied from its cached serialization
+        void appendToJsonArray(std::string& arr, const DataModel::Talkgroup& tg)
+        {
+            arr.append(arr.empty() ? "[" : ",");
+            tg.appendJson(arr);
+        }
+
+        void appendToJsonArray(std::string& arr, const LazyTalkgroup& tg)
+        {
+            arr.append(arr.empty() ? "[" : ",");
+            tg.appendJson(arr);
+        }
+
+        // Inserts an already-serialized member into a dumped JSON object, ahead of its closing brace
+        void spliceJsonMember(std::string& obj, const char *name, const std::string& value)
+        {
+            obj.pop_back();
+            if(obj.size() > 1)
+            {
+                obj.append(",");
             }
+            obj.append("\"");
+            obj.append(name);
+            obj.append("\":");
+            obj.append(value);
+            obj.append("}");
+        }
 
-            // Reset these
-            dt->_consecutiveErrors = 0;
-            dt->_nextCheckTs = 0;            
+        // Merges a change into whatever is already pending for the talkgroup so that only the net effect is delivered
+        void queueTalkgroupChange(PendingChange_t::ChangeKind_t kind, const ContentStore::TalkgroupPtr& tg, const ContentStore::TalkgroupPtr& prev = ContentStore::TalkgroupPtr())
+        {
+            m_journal.append((kind == PendingChange_t::ckNew ? ChangeJournal::opAdd : 
+                              (kind == PendingChange_t::ckModified ? ChangeJournal::opModify : ChangeJournal::opRemove)), tg);
+
+            std::string key = tg->deviceKey();
+            key.append("/");
+            key.append(tg->id());
+
+            PendingChangeMap_t::iterator itr = m_pendingChanges.find(key);
+            if(itr == m_pendingChanges.end())
+            {
+                PendingChange_t pc;
+                pc._kind = kind;
+                pc._tg = tg;
+                pc._prev = prev;
+                m_pendingChanges[key] = pc;
+                return;
+            }
 
-            std::vector<std::string>     newTalkGroups;
-            std::vector<std::string>     modifiedTalkGroups;
-            std::vector<std::string>     removedTalkGroups;
+            PendingChange_t *pc = &itr->second;
 
-            // Look for new or modified
-            for(std::vector<DataModel::Talkgroup>::iterator itrIncoming = dc->talkgroups.begin();
-                itrIncoming != dc->talkgroups.end();
-                itrIncoming++)
+            if(kind == PendingChange_t::ckRemoved)
             {
-                DataModel::Talkgroup *tg = getTalkgroup(itrIncoming->id.c_str(), dt->_cfg.talkgroups);
-                if(tg != nullptr)
+                if(pc->_kind == PendingChange_t::ckNew)
                 {
-                    if(!itrIncoming->matches(*tg))
-                    {
-                        modifiedTalkGroups.push_back(itrIncoming->id);
-                    }
+                    // Came and went within the window - the application never needs to know
+                    m_pendingChanges.erase(itr);
                 }
                 else
                 {
-                    newTalkGroups.push_back(itrIncoming->id);
+                    pc->_kind = PendingChange_t::ckRemoved;
+                    pc->_tg = tg;
+                }
+            }
+            else
+            {
+                // New stays new, anything on top of a removal means the application's copy is now out of date.  Deltas
+                // are always against what the application saw before the window opened.
+                if(pc->_kind == PendingChange_t::ckRemoved)
+                {
+                    pc->_kind = PendingChange_t::ckModified;
+                    pc->_prev = pc->_tg;
                 }
+                pc->_tg = tg;
+            }
+        }
+
+        bool anyoneListening()
+        {
+            if(m_pfnOnNewTalkgroupViews != nullptr || m_pfnOnModifiedTalkgroupViews != nullptr || m_pfnOnRemovedTalkgroupViews != nullptr)
+            {
+                return true;
             }
 
-            // Look for removed
-            for(std::vector<DataModel::Talkgroup>::iterator itrExisting = dt->_cfg.talkgroups.begin();
-                itrExisting != dt->_cfg.talkgroups.end();
-                itrExisting++)
+            for(SubscriberMap_t::iterator itr = m_subscribers.begin();
+                itr != m_subscribers.end();
+                itr++)
             {
-                DataModel::Talkgroup *tg = getTalkgroup(itrExisting->id.c_str(), dc->talkgroups);
-                if(tg == nullptr)
+                if(itr->second._pfnOnNew != nullptr || itr->second._pfnOnModified != nullptr || itr->second._pfnOnRemoved != nullptr)
                 {
-                    removedTalkGroups.push_back(itrExisting->id);
+                    return true;
                 }
             }
-            
-            // Notify for removals
-            if(!removedTalkGroups.empty() && m_pfnOnRemovedTalkgroups != nullptr)
+
+            return false;
+        }
+
+        void flushTalkgroupChanges()
+        {
+            if(m_pendingChanges.empty())
+            {
+                return;
+            }
+
+            // Nobody to tell - talkgroups that are still encoded can stay that way
+            if(!anyoneListening())
             {
-                nlohmann::json idArray = nlohmann::json::array();
+                m_pendingChanges.clear();
+                return;
+            }
 
-                for(std::vector<std::string>::iterator itrNotify = removedTalkGroups.begin();
-                    itrNotify != removedTalkGroups.end();
-                    itrNotify++)
+            std::vector<LazyTalkgroup::TalkgroupPtr>    tgs[3];
+            std::vector<uint32_t>                       modifiedMasks;
+            std::vector<nlohmann::json>                 modifiedPatches;
+            bool                                        wantDeltas = (m_configuration.notifications.modifiedDeltas || m_pfnOnModifiedTalkgroupViews != nullptr);
+
+            for(PendingChangeMap_t::iterator itr = m_pendingChanges.begin();
+                itr != m_pendingChanges.end();
+                itr++)
+            {
+                if(itr->second._kind == PendingChange_t::ckModified && wantDeltas)
                 {
-                    DataModel::Talkgroup *tg = getTalkgroup(itrNotify->c_str(), dt->_cfg.talkgroups);
-                    if(tg != nullptr)
-                    {
-                        getLogger()->d(TAG, "notify of removed tg '%s'", itrNotify->c_str());
+                    nlohmann::json patch;
+                    uint32_t mask = computeTalkgroupDelta(itr->second, patch);
 
-                        idArray.push_back(itrNotify->c_str());
-                    }
-                    else
+                    // Changed and changed back within the window
+                    if(mask == 0)
                     {
-                        getLogger()->e(TAG, "cannot find tg '%s' in existing configuration", itrNotify->c_str());
+                        continue;
                     }
+
+                    modifiedMasks.push_back(mask);
+                    modifiedPatches.push_back(patch);
                 }
 
-                m_pfnOnRemovedTalkgroups(idArray.dump().c_str(), m_pfOnTgUserData);
+                tgs[itr->second._kind].push_back(itr->second._tg->get());
             }
 
-            // Notify for updates
-            if(!modifiedTalkGroups.empty() && m_pfnOnModifiedTalkgroups != nullptr)
+            // Removals first, then updates, then additions
+            const std::vector<LazyTalkgroup::TalkgroupPtr>& removed = tgs[PendingChange_t::ckRemoved];
+            const std::vector<LazyTalkgroup::TalkgroupPtr>& modified = tgs[PendingChange_t::ckModified];
+            const std::vector<LazyTalkgroup::TalkgroupPtr>& added = tgs[PendingChange_t::ckNew];
+
+            getLogger()->d(TAG, "delivering talkgroup changes - %zu removed, %zu modified, %zu new", removed.size(), modified.size(), added.size());
+
+            if(!removed.empty() && m_pfnOnRemovedTalkgroupViews != nullptr)
             {
-                nlohmann::json tgArray = nlohmann::json::array();
+                std::shared_ptr<TalkgroupViewSet> views = std::make_shared<TalkgroupViewSet>();
+                for(size_t x = 0; x < removed.size(); x++)
+                {
+                    views->addId(removed[x]->id);
+                }
+
+                deliverViews("onRemovedTalkgroupViews", m_pfnOnRemovedTalkgroupViews, views, m_pfOnTgViewUserData);
+            }
 
-                for(std::vector<std::string>::iterator itrNotify = modifiedTalkGroups.begin();
-                    itrNotify != modifiedTalkGroups.end();
-                    itrNotify++)
+            if(!modified.empty() && m_pfnOnModifiedTalkgroupViews != nullptr)
+            {
+                std::shared_ptr<TalkgroupViewSet> views = std::make_shared<TalkgroupViewSet>();
+                for(size_t x = 0; x < modified.size(); x++)
                 {
-                    DataModel::Talkgroup *tg = getTalkgroup(itrNotify->c_str(), dc->talkgroups);
-                    if(tg != nullptr)
-                    {
-                        getLogger()->d(TAG, "notify of modified tg '%s'", itrNotify->c_str());
+                    views->add(*modified[x], modifiedMasks[x]);
+                }
 
-                        tgArray.push_back((*tg));
-                    }
-                    else
-                    {
-                        getLogger()->e(TAG, "cannot find modified tg '%s' in new configuration", itrNotify->c_str());
-                    }
+                deliverViews("onModifiedTalkgroupViews", m_pfnOnModifiedTalkgroupViews, views, m_pfOnTgViewUserData);
+            }
+
+            if(!added.empty() && m_pfnOnNewTalkgroupViews != nullptr)
+            {
+                std::shared_ptr<TalkgroupViewSet> views = std::make_shared<TalkgroupViewSet>();
+                for(size_t x = 0; x < added.size(); x++)
+                {
+                    views->add(*added[x]);
                 }
 
-                m_pfnOnModifiedTalkgroups(tgArray.dump().c_str(), m_pfOnTgUserData);
+                deliverViews("onNewTalkgroupViews", m_pfnOnNewTalkgroupViews, views, m_pfOnTgViewUserData);
             }
 
-            // Notify for additions
-            if(!newTalkGroups.empty() && m_pfnOnModifiedTalkgroups != nullptr)
+            // Talkgroups carry their serialization from download time while ids and deltas are serialized at
+            // most once, and only if some subscriber actually wants them
+            std::vector<std::string>    removedJson(removed.size());
+            std::vector<std::string>    modifiedJson(modified.size());
+
+            for(SubscriberMap_t::iterator itrSub = m_subscribers.begin();
+                itrSub != m_subscribers.end();
+                itrSub++)
             {
-                nlohmann::json tgArray = nlohmann::json::array();
+                const Subscriber_t *sub = &itrSub->second;
+                std::string arr;
 
-                for(std::vector<std::string>::iterator itrNotify = newTalkGroups.begin();
-                    itrNotify != newTalkGroups.end();
-                    itrNotify++)
+                if(sub->_pfnOnRemoved != nullptr)
                 {
-                    DataModel::Talkgroup *tg = getTalkgroup(itrNotify->c_str(), dc->talkgroups);
-                    if(tg != nullptr)
+                    arr.clear();
+                    for(size_t x = 0; x < removed.size(); x++)
                     {
-                        getLogger()->d(TAG, "notify of new tg '%s'", itrNotify->c_str());
-
-                        tgArray.push_back((*tg));
+                        if(sub->_filter.wants(*removed[x]))
+                        {
+                            if(removedJson[x].empty())
+                            {
+                                removedJson[x] = nlohmann::json(removed[x]->id).dump();
+                            }
+                            appendToJsonArray(arr, removedJson[x]);
+                        }
                     }
-                    else
+
+                    if(!arr.empty())
                     {
-                        getLogger()->e(TAG, "cannot find new tg '%s' in new configuration", itrNotify->c_str());
+                        arr.append("]");
+                        deliverJson("onRemovedTalkgroups", sub->_pfnOnRemoved, arr, sub->_userData);
                     }
                 }
 
-                m_pfnOnNewTalkgroups(tgArray.dump().c_str(), m_pfOnTgUserData);
-            }
-
-            // Update our cached configuration
+                if(sub->_pfnOnModified != nullptr)
+                {
+                    arr.clear();
+                    for(size_t x = 0; x < modified.size(); x++)
+                    {
+                        if(sub->_filter.wants(*modified[x]))
+                        {
+                            if(m_configuration.notifications.modifiedDeltas)
+                            {
+                                if(modifiedJson[x].empty())
+                                {
+                                    nlohmann::json delta;
+                                    delta["id"] = modified[x]->id;
+                                    delta["deviceKey"] = modified[x]->deviceKey;
+                                    delta["changeMask"] = modifiedMasks[x];
+                                    delta["patch"] = modifiedPatches[x];
+                                    modifiedJson[x] = delta.dump();
+                                }
+                                appendToJsonArray(arr, modifiedJson[x]);
+                            }
+                            else
+                            {
+                                appendToJsonArray(arr, *modified[x]);
+                            }
+                        }
+                    }
+
+                    if(!arr.empty())
+                    {
+                        arr.append("]");
+                        deliverJson("onModifiedTalkgroups", sub->_pfnOnModified, arr, sub->_userData);
+                    }
+                }
+
+                if(sub->_pfnOnNew != nullptr)
+                {
+                    arr.clear();
+                    for(size_t x = 0; x < added.size(); x++)
+                    {
+                        if(sub->_filter.wants(*added[x]))
+                        {
+                            appendToJsonArray(arr, *added[x]);
+                        }
+                    }
+
+                    if(!arr.empty())
+                    {
+                        arr.append("]");
+                        deliverJson("onNewTalkgroups", sub->_pfnOnNew, arr, sub->_userData);
+                    }
+                }
+            }
+
+            m_pendingChanges.clear();
+        }
+
+        // Called after a batch of changes has been queued - delivers now unless we're coalescing
+        void talkgroupChangesQueued()
+        {
+            if(m_configuration.notifications.coalesceWindowMs == 0 ||
+               m_pendingChanges.size() >= m_configuration.notifications.maxCoalescedChanges)
+            {
+                flushTalkgroupChanges();
+            }
+        }
+
+        // Shared talkgroups may be another device's - this is the talkgroup as the application knows it (from the
+        // snapshot if that's where the device's copy is, otherwise taken on for the device)
+        ContentStore::TalkgroupPtr deviceTalkgroup(const TalkgroupRegistry& snap, const ContentStore::TalkgroupPtr& tg, const std::string& deviceKey)
+        {
+            TalkgroupRegistry::TalkgroupPtr held = snap.get(tg->id(), deviceKey);
+            if(held)
+            {
+                return held;
+            }
+
+            return tg->forDevice(deviceKey);
+        }
+
+        void notifyOfLostDevice(DeviceTracker *dt)
+        {
+            if(!dt->_cfg)
+            {
+                // Nothing was ever accepted from it but turning something away may have put it in the snapshot
+                std::shared_ptr<const TalkgroupRegistry> current = loadSnapshot();
+                if(current && current->getDevices().find(dt->key()) != current->getDevices().end())
+                {
+                    std::shared_ptr<TalkgroupRegistry> snap = cloneSnapshot();
+                    snap->removeDevice(dt->key());
+                    publishSnapshot(snap);
+                }
+
+                return;
+            }
+
+            std::shared_ptr<TalkgroupRegistry> snap = cloneSnapshot();
+
+            ContentStore::TalkgroupList_t gone;
+            for(ContentStore::TalkgroupList_t::const_iterator itrTg = dt->_cfg->_talkgroups.begin();
+                itrTg != dt->_cfg->_talkgroups.end();
+                itrTg++)
+            {
+                gone.push_back(deviceTalkgroup(*snap, *itrTg, dt->key()));
+            }
+
+            snap->removeDevice(dt->key());
+
+            for(ContentStore::TalkgroupList_t::iterator itrTg = gone.begin();
+                itrTg != gone.end();
+                itrTg++)
+            {
+                getLogger()->d(TAG, "tg '%s' has gone", (*itrTg)->id().c_str());
+                queueTalkgroupChange(PendingChange_t::ckRemoved, *itrTg);
+            }
+
+            publishSnapshot(snap);
+            talkgroupChangesQueued();
+        }
+
+        // Drops a device along with any routes to it, letting go of their keys
+        DeviceMap_t::iterator eraseDevice(DeviceMap_t::iterator itrDev)
+        {
+            for(DeviceTracker::RouteMap_t::iterator itrRoute = itrDev->second._routes.begin();
+                itrRoute != itrDev->second._routes.end();
+                itrRoute++)
+            {
+                m_routes.erase(itrRoute->first);
+                m_strings.release(itrRoute->first);
+            }
+
+            m_strings.release(itrDev->first);
+
+            return m_devices.erase(itrDev);
+        }
+
+        void forgetDevice(StringTable::Handle_t deviceKey)
+        {
+            DeviceMap_t::iterator itrDev = m_devices.find(deviceKey);
+            if(itrDev != m_devices.end())
+            {
+                eraseDevice(itrDev);
+            }
+        }
+
+        void processDeviceConfiguration(const char *deviceKey, DeviceTracker *dt, DataModel::DeviceConfiguration *dc, const ContentStore::TalkgroupList_t *talkgroups, bool encounteredError)
+        {
+            // Did we encounter an error?
+            if(encounteredError)
+            {
+                dt->_consecutiveErrors++;
+
+                if(dt->_consecutiveErrors >= m_configuration.restLink.maxUrlConsecutiveErrors)
+                {
+                    if(m_configuration.restLink.abandonUrlsAfterConsecutiveErrors)
+                    {
+                        getLogger()->e(TAG, "too many consecutive errors on %s - abandoning", deviceKey);
+                        notifyOfLostDevice(dt);
+                        forgetDevice(dt->_key);
+
+                        // NOTE: Early return here
+                        return;
+                    }
+
+                    // Stay at ceiling
+                    dt->_consecutiveErrors = m_configuration.restLink.maxUrlConsecutiveErrors;
+                }
+
+                // If another discoverer also sees this device, try that path next time around
+                dt->rotateRoute();
+
+                uint64_t now = getNowMs();
+                uint64_t rndAmount = (rand() % (dt->_consecutiveErrors * m_configuration.restLink.urlRetryIntervalMs));
+
+                dt->_nextCheckTs = ((now + (dt->_consecutiveErrors * 1000)) + rndAmount);
+                dt->_ps = DeviceTracker::psPending;
+                getLogger()->e(TAG, "scheduled next check of %s via %s in %" PRIu64 " milliseconds", deviceKey, dt->_url.c_str(), (dt->_nextCheckTs - now));
+                
+                // NOTE: Early return here
+                return;
+            }
+
+            // Reset these
+            dt->_consecutiveErrors = 0;
+            dt->_nextCheckTs = 0;            
+
+            // Identical content comes back as the very configuration we already hold
+            ContentStore::ConfigurationPtr cfg = m_contentStore.intern(dc->version, *talkgroups);
+            bool unchanged = (cfg == dt->_cfg);
+
+            // Each device is charged for all it serves, shared or not
+            dt->_heldBytes = 0;
+            for(ContentStore::TalkgroupList_t::const_iterator itrTg = talkgroups->begin();
+                itrTg != talkgroups->end();
+                itrTg++)
+            {
+                dt->_heldBytes += (*itrTg)->footprint();
+            }
+
+            TalkgroupRegistry::DeviceSummary_t summary;
+            summary._url = dt->_url;
+            summary._configVersion = dc->version;
+            summary._wireBytes = dt->_wireBytes;
+            summary._bodyBytes = dt->_bodyBytes;
+            summary._heldBytes = dt->_heldBytes;
+            summary._parseBytes = dt->_parseBytes;
+            summary._rejectedBodies = dt->_rejectedBodies;
+            summary._provisional = dt->_provisional;
+
+            if(unchanged)
+            {
+                getLogger()->d(TAG, "%s configuration version %lu is unchanged", deviceKey, (unsigned long) cfg->_version);
+            }
+
+            // Copying the registry is only worth it if something in it is going to change - the device's counters
+            // moving is enough though as they're published with it
+            std::shared_ptr<const TalkgroupRegistry> current = loadSnapshot();
+            if(!unchanged || !current || !current->holdsDevice(deviceKey, summary))
+            {
+                // Build the new state - it's published before telling anyone so lookups from inside callbacks see it
+                std::shared_ptr<TalkgroupRegistry> snap = cloneSnapshot();
+                snap->putDevice(deviceKey, summary);
+
+                if(!unchanged)
+                {
+                    // Look for new or modified - shared talkgroups are the same object if (and only if) they're the same
+                    for(size_t x = 0; x < cfg->_talkgroups.size(); x++)
+                    {
+                        const ContentStore::TalkgroupPtr& incoming = cfg->_talkgroups[x];
+                        ContentStore::TalkgroupPtr existing = ContentStore::find(dt->_cfg, incoming->id());
+
+                        // Encoded and decoded talkgroups are never shared so they're compared the long way when a
+                        // configuration has crossed the threshold for lazy decoding
+                        if(existing == incoming ||
+                           (existing && existing->isEncoded() != incoming->isEncoded() && existing->sameContent(*incoming)))
+                        {
+                            continue;
+                        }
+
+                        // Our own talkgroup - the shared one may be another device's
+                        const ContentStore::TalkgroupPtr& tg = (*talkgroups)[x];
+
+                        if(existing)
+                        {
+                            ContentStore::TalkgroupPtr prev = deviceTalkgroup(*snap, existing, deviceKey);
+                            snap->put(tg);
+                            queueTalkgroupChange(PendingChange_t::ckModified, tg, prev);
+                        }
+                        else
+                        {
+                            snap->put(tg);
+                            queueTalkgroupChange(PendingChange_t::ckNew, tg);
+                        }
+                    }
+
+                    // Look for removed
+                    if(dt->_cfg)
+                    {
+                        for(ContentStore::TalkgroupList_t::const_iterator itrExisting = dt->_cfg->_talkgroups.begin();
+                            itrExisting != dt->_cfg->_talkgroups.end();
+                            itrExisting++)
+                        {
+                            if(!ContentStore::find(cfg, (*itrExisting)->id()))
+                            {
+                                ContentStore::TalkgroupPtr tg = deviceTalkgroup(*snap, *itrExisting, deviceKey);
+                                snap->remove(tg->id(), deviceKey);
+                                queueTalkgroupChange(PendingChange_t::ckRemoved, tg);
+                            }
+                        }
+                    }
+                }
+
+                publishSnapshot(snap);
+            }
+
+            if(!unchanged)
+            {
+                talkgroupChangesQueued();
+            }
+
+            // Hold on to the shared configuration
+            dt->_ps = DeviceTracker::psComplete;
+            dt->_cfg = cfg;
+
+            convergeOnAdvertisedVersion(deviceKey, dt);
+        }
+
+        // The device sent exactly the body we last processed so there's nothing to parse, diff or tell anyone about
+        void processIdenticalBody(DeviceTracker *dt)
+        {
+            m_downloadStats._identicalBodies++;
+            getLogger()->d(TAG, "%s served the same body as last time - configuration version %lu is unchanged", dt->key().c_str(), (unsigned long) dt->configVersion());
+
+            dt->_consecutiveErrors = 0;
+            dt->_nextCheckTs = 0;
             dt->_ps = DeviceTracker::psComplete;
-            dt->_cfg = (*dc);
+
+            convergeOnAdvertisedVersion(dt->key().c_str(), dt);
+        }
+
+        // Follows up a successful fetch if what the device served isn't what it's advertising
+        void convergeOnAdvertisedVersion(const char *deviceKey, DeviceTracker *dt)
+        {
+            // A bump during the fetch is moot if what came back is already that version (or newer)
+            if(dt->_refetchWanted && dt->configVersion() >= dt->_advertisedVersion)
+            {
+                dt->_refetchWanted = false;
+            }
+
+            if(dt->configVersion() >= dt->_advertisedVersion)
+            {
+                dt->_staleFetches = 0;
+            }
+            else if(dt->_refetchWanted)
+            {
+                // The version moved while we were fetching - go again right away
+                getLogger()->d(TAG, "%s received version %lu but %lu is advertised - refetching", deviceKey, (unsigned long) dt->configVersion(), dt->_advertisedVersion);
+                dt->_staleFetches = 0;
+                startFetch(dt);
+            }
+            else
+            {
+                // The device served an older body than it advertises (typically a cache or a publish race) so
+                // back off and try again, giving up once the retry ceiling is reached
+                dt->_staleFetches++;
+                if(dt->_staleFetches < m_configuration.restLink.maxUrlConsecutiveErrors)
+                {
+                    uint64_t now = getNowMs();
+                    dt->_nextCheckTs = (now + (dt->_staleFetches * m_configuration.restLink.urlRetryIntervalMs));
+                    dt->_ps = DeviceTracker::psPending;
+                    getLogger()->w(TAG, "%s served version %lu but advertises %lu - rechecking in %" PRIu64 " milliseconds", deviceKey, (unsigned long) dt->configVersion(), dt->_advertisedVersion, (dt->_nextCheckTs - now));
+                }
+                else
+                {
+                    // _fetchVersion is left at the version given up on so only a different one starts over
+                    getLogger()->e(TAG, "%s still serving version %lu instead of %lu - giving up until another version is advertised", deviceKey, (unsigned long) dt->configVersion(), dt->_advertisedVersion);
+                }
+            }
+        }
+
+        // Stamps decoded (or cached) talkgroups with their device, captures their serialization and moves them
+        // into the list processDeviceConfiguration() works from
+        void prepareTalkgroups(DataModel::DeviceConfiguration& dc, const std::string& deviceKey, ContentStore::TalkgroupList_t& talkgroups)
+        {
+            talkgroups.clear();
+            talkgroups.reserve(dc.talkgroups.size());
+
+            for(std::vector<DataModel::Talkgroup>::iterator itr = dc.talkgroups.begin();
+                itr != dc.talkgroups.end();
+                itr++)
+            {
+                itr->deviceKey.assign(deviceKey);
+                itr->cacheJson();
+                talkgroups.push_back(LazyTalkgroup::fromTalkgroup(std::make_shared<const DataModel::Talkgroup>(std::move(*itr))));
+            }
+
+            dc.talkgroups.clear();
+        }
+
+        // Uses the cached configuration instead of fetching if it's the version the device is advertising
+        bool useCachedConfiguration(DeviceTracker *dt)
+        {
+            // Without an advertised version there's no telling whether the cache is current
+            if(!m_cache.isOpen() || dt->_advertisedVersion == 0)
+            {
+                return false;
+            }
+
+            DataModel::DeviceConfiguration dc;
+            if(!m_cache.find(dt->key(), dt->_advertisedVersion, dc))
+            {
+                return false;
+            }
+
+            getLogger()->d(TAG, "%s advertised version %lu - using cached configuration", dt->key().c_str(), dt->_advertisedVersion);
+
+            const std::string& deviceKey = dt->key();
+            ContentStore::TalkgroupList_t talkgroups;
+            dc.discovererKey = deviceKey;
+            prepareTalkgroups(dc, deviceKey, talkgroups);
+            dt->_staleFetches = 0;
+            dt->_bodyHash = 0;
+            processDeviceConfiguration(deviceKey.c_str(), dt, &dc, &talkgroups, false);
+
+            return true;
+        }
+
+        // Puts cached devices in place ahead of discovery so the application has talkgroups right away
+        void presentCachedDevices()
+        {
+            ConfigurationCache::EntryList_t entries;
+            m_cache.getEntries(entries);
+
+            uint64_t now = getNowMs();
+
+            for(ConfigurationCache::EntryList_t::iterator itr = entries.begin();
+                itr != entries.end();
+                itr++)
+            {
+                // Already rediscovered
+                if(m_devices.find(m_strings.find(itr->_deviceKey)) != m_devices.end())
+                {
+                    continue;
+                }
+
+                DataModel::DeviceConfiguration dc;
+                if(!m_cache.find(itr->_deviceKey, dc))
+                {
+                    continue;
+                }
+
+                // The device's own reference to its key
+                StringTable::Handle_t deviceKey = m_strings.intern(itr->_deviceKey);
+
+                ContentStore::TalkgroupList_t talkgroups;
+                dc.discovererKey = itr->_deviceKey;
+                prepareTalkgroups(dc, itr->_deviceKey, talkgroups);
+
+                DeviceTracker dt;
+                dt._key = deviceKey;
+                dt._url = itr->_url;
+                dt._provisional = true;
+                dt._provisionalUntil = (now + m_configuration.cache.provisionalLifetimeMs);
+                m_devices[deviceKey] = dt;
+
+                getLogger()->i(TAG, "presenting %zu cached talkgroup(s) from %s (version %lu) provisionally", talkgroups.size(), itr->_deviceKey.c_str(), itr->_version);
+
+                processDeviceConfiguration(itr->_deviceKey.c_str(), &m_devices[deviceKey], &dc, &talkgroups, false);
+            }
+        }
+
+        // A body broke the limits - the snapshot is told even if nothing has ever been accepted from the device
+        void publishRejection(DeviceTracker *dt)
+        {
+            std::shared_ptr<TalkgroupRegistry> snap = cloneSnapshot();
+            TalkgroupRegistry::DeviceSummary_t summary;
+
+            TalkgroupRegistry::DeviceMap_t::const_iterator itr = snap->getDevices().find(dt->key());
+            if(itr != snap->getDevices().end())
+            {
+                summary = itr->second;
+            }
+            else
+            {
+                summary._url = dt->_url;
+                summary._configVersion = dt->configVersion();
+                summary._heldBytes = dt->_heldBytes;
+                summary._parseBytes = dt->_parseBytes;
+                summary._provisional = dt->_provisional;
+            }
+
+            summary._wireBytes = dt->_wireBytes;
+            summary._bodyBytes = dt->_bodyBytes;
+            summary._rejectedBodies = dt->_rejectedBodies;
+            snap->putDevice(dt->key(), summary);
+            publishSnapshot(snap);
+        }
+
+        // A provisional device has been rediscovered - it's now like any other
+        void confirmProvisionalDevice(DeviceTracker *dt)
+        {
+            dt->_provisional = false;
+            dt->_provisionalUntil = 0;
+
+            std::shared_ptr<TalkgroupRegistry> snap = cloneSnapshot();
+            TalkgroupRegistry::DeviceMap_t::const_iterator itr = snap->getDevices().find(dt->key());
+            if(itr != snap->getDevices().end())
+            {
+                TalkgroupRegistry::DeviceSummary_t summary = itr->second;
+                summary._url = dt->_url;
+                summary._provisional = false;
+                snap->putDevice(dt->key(), summary);
+                publishSnapshot(snap);
+            }
+
+            getLogger()->d(TAG, "cached device %s has been rediscovered at %s", dt->key().c_str(), dt->_url.c_str());
         }
 
         class DeviceConfigurationDownloadCtx
@@ -462,10 +1492,33 @@ namespace Magellan
                 DeviceConfigurationDownloadCtx()
                 {
                     _ok = false;
+                    _lazy = false;
+                    _identical = false;
+                    _wireBytes = 0;
+                    _bodyBytes = 0;
+                    _bodyHash = 0;
+                    _maxBodyBytes = 0;
+                    _violation = ConfigurationLimits::lvNone;
+                    _parseBytes = 0;
+                    _cacheBodyIsCbor = true;
                 }
 
                 bool                                _ok;
+                bool                                _lazy;
+                bool                                _identical;
+                uint64_t                            _wireBytes;
+                uint64_t                            _bodyBytes;
+                uint64_t                            _bodyHash;
+                uint64_t                            _maxBodyBytes;
+                ConfigurationLimits::Violation_t    _violation;
+                uint64_t                            _parseBytes;
+                std::string                         _body;
                 DataModel::DeviceConfiguration      _dc;
+                ContentStore::TalkgroupList_t       _talkgroups;
+
+                // The configuration for the cache (if there is one) - CBOR unless a large JSON body is kept as is
+                std::vector<uint8_t>                _cacheBody;
+                bool                                _cacheBodyIsCbor;
         };
 
         static size_t curlCbDataToDeviceConfiguration(void *ptr, size_t size, size_t nmemb, void *userData)
@@ -473,22 +1526,175 @@ namespace Magellan
             DeviceConfigurationDownloadCtx *ctx = (DeviceConfigurationDownloadCtx*)userData;
             //getLogger()->d(TAG, "curlCbDataToDeviceConfiguration: ptr=%p, size=%zu, nmemb=%zu, ctx=%p", ptr, size, nmemb, (void*)ctx);
 
-            std::string tmp;
+            // Refusing the data abandons the transfer - there's no point taking in the rest of a body that's too big
+            if(ctx->_maxBodyBytes > 0 && (ctx->_body.size() + (size * nmemb)) > ctx->_maxBodyBytes)
+            {
+                ctx->_violation = ConfigurationLimits::lvBodyBytes;
+                return 0;
+            }
 
-            tmp.assign((char*)ptr, size*nmemb);
-            ctx->_ok = ctx->_dc.deserialize(tmp.c_str());
+            // The body can arrive in any number of pieces so it's only decoded once the transfer is complete
+            ctx->_body.append((char*)ptr, size*nmemb);
 
             return (size * nmemb);
         }
 
-        void doUrlDownload(const char *url, const char *discovererKey)
+        static bool isCborContentType(const char *contentType)
         {
-            getLogger()->d(TAG, "doUrlDownload from %s for %s", url, discovererKey);
+            if(contentType == nullptr)
+            {
+                return false;
+            }
+
+            std::string ct = contentType;
+            std::transform(ct.begin(), ct.end(), ct.begin(), ::tolower);
+
+            return (ct.find("application/cbor") == 0);
+        }
+
+        // Tallies a body turned away for breaking one of the configured limits
+        static void countViolation(ConfigurationLimits::Violation_t v)
+        {
+            switch(v)
+            {
+                case ConfigurationLimits::lvBodyBytes:
+                    m_downloadStats._overBodyBytes++;
+                    break;
+
+                case ConfigurationLimits::lvTalkgroups:
+                    m_downloadStats._overTalkgroups++;
+                    break;
+
+                case ConfigurationLimits::lvRallypoints:
+                    m_downloadStats._overRallypoints++;
+                    break;
+
+                case ConfigurationLimits::lvStringLength:
+                    m_downloadStats._overStringLength++;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        // Decodes a downloaded configuration according to the content type the device responded with.  Configurations
+        // with enough talkgroups only have them located - each is decoded when something first needs it.
+        static bool decodeDeviceConfiguration(DeviceConfigurationDownloadCtx *ctx, const char *contentType, const std::string& deviceKey, const ConfigurationLimits& limits, uint64_t lastBodyHash)
+        {
+            bool isCbor = isCborContentType(contentType);
+            bool wantCacheBody = !m_configuration.cache.directory.empty();
+            unsigned long threshold = m_configuration.restLink.lazyTalkgroupThreshold;
+            size_t bodySize = ctx->_body.size();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool rc = false;
+
+            m_downloadStats._bytes += bodySize;
+            ctx->_bodyBytes = bodySize;
+
+            // Devices without conditional requests often send the very same body again - nothing to decode then
+            ctx->_bodyHash = ConfigurationScanner::hashBytes(ctx->_body.data(), bodySize);
+            if(lastBodyHash != 0 && ctx->_bodyHash == lastBodyHash)
+            {
+                ctx->_identical = true;
+                ctx->_body.clear();
+                return true;
+            }
+
+            // Nothing gets built for a configuration bigger than we're prepared to hold
+            ctx->_violation = limits.check(ctx->_body, isCbor);
+            if(ctx->_violation != ConfigurationLimits::lvNone)
+            {
+                ctx->_body.clear();
+                return false;
+            }
+
+            // The parse tree only lives for this decode so it's built in the arena and dropped in one go
+            try
+            {
+                ParseArena::Scope scope(m_parseArena);
+                ConfigurationScanner scanner;
+
+                if(threshold > 0 && scanner.scan(ctx->_body, isCbor) && scanner.talkgroups().size() >= threshold)
+                {
+                    // Everything but the talkgroups
+                    std::string remainder = scanner.remainder();
+                    ArenaJson dom = (isCbor ? ArenaJson::from_cbor(remainder) : ArenaJson::parse(remainder));
+                    DataModel::fieldsFromJson(dom, ctx->_dc);
+
+                    // Re-encoding would mean the full decode this is avoiding so the body goes in as it came
+                    if(wantCacheBody)
+                    {
+                        ctx->_cacheBody.assign(ctx->_body.begin(), ctx->_body.end());
+                        ctx->_cacheBodyIsCbor = isCbor;
+                    }
+
+                    // The talkgroups stay where they are in the body, which they now share
+                    LazyTalkgroup::BodyPtr body = std::make_shared<const std::string>(std::move(ctx->_body));
+                    const ConfigurationScanner::TalkgroupList_t& located = scanner.talkgroups();
+
+                    ctx->_talkgroups.reserve(located.size());
+                    for(ConfigurationScanner::TalkgroupList_t::const_iterator itr = located.begin();
+                        itr != located.end();
+                        itr++)
+                    {
+                        ctx->_talkgroups.push_back(LazyTalkgroup::fromEncoding(itr->_id, deviceKey, body, itr->_offset, itr->_length, isCbor));
+                    }
+
+                    ctx->_lazy = true;
+                }
+                else
+                {
+                    ArenaJson dom = (isCbor ? ArenaJson::from_cbor(ctx->_body) : ArenaJson::parse(ctx->_body));
+                    DataModel::fieldsFromJson(dom, ctx->_dc);
+                }
+
+                rc = true;
+            }
+            catch(...)
+            {
+                rc = false;
+            }
+
+            ctx->_parseBytes = m_parseArena.inUse();
+            m_parseArena.reset();
+
+            m_downloadStats._decodeUs += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            if(ctx->_lazy)
+            {
+                m_downloadStats._lazyBodies++;
+            }
+            if(isCbor)
+            {
+                m_downloadStats._cborBodies++;
+            }
+            else
+            {
+                m_downloadStats._jsonBodies++;
+            }
+
+            if(!rc)
+            {
+                getLogger()->e(TAG, "cannot decode %zu byte %s configuration", bodySize, (isCbor ? "CBOR" : "JSON"));
+            }
+
+            ctx->_body.clear();
+
+            return rc;
+        }
+
+        void doUrlDownload(const char *url, StringTable::Handle_t deviceKey, uint64_t lastBodyHash)
+        {
+            const std::string& key = m_strings.get(deviceKey);
+
+            getLogger()->d(TAG, "doUrlDownload from %s for %s", url, key.c_str());
 
             CURL *curl_handle;
             CURLcode cc;
 
+            ConfigurationLimits limits(m_configuration.restLink);
             DeviceConfigurationDownloadCtx *dcctx = new DeviceConfigurationDownloadCtx();
+            dcctx->_maxBodyBytes = limits.maxBodyBytes();
 
             curl_handle = curl_easy_init();
 
@@ -506,49 +1712,155 @@ namespace Magellan
             
             curl_easy_setopt(curl_handle, CURLOPT_CAINFO, m_configuration.restLink.caBundle.c_str());
 
-            curl_easy_setopt(curl_handle, CURLOPT_SSL_OPTIONS, CURLSSLOPT_NO_REVOKE);
+            curl_easy_setopt(curl_handle, CURLOPT_SSL_OPTIONS, CURLSSLOPT_NO_REVOKE);
+
+            curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYPEER, (m_configuration.restLink.verifyPeer ? 1L : 0L));
+            curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYHOST, (m_configuration.restLink.verifyHost ? 1L : 0L));
+
+            curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, dcctx);
+            curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, curlCbDataToDeviceConfiguration);
+
+            // Lets libcurl refuse a body that says up front it's too big (a compressed one is caught as it inflates)
+            if(limits.maxBodyBytes() > 0)
+            {
+                curl_easy_setopt(curl_handle, CURLOPT_MAXFILESIZE_LARGE, (curl_off_t)limits.maxBodyBytes());
+            }
+
+            // Devices that don't speak CBOR simply ignore the preference and send JSON
+            struct curl_slist *headers = nullptr;
+            headers = curl_slist_append(headers, (m_configuration.restLink.acceptCbor ? "Accept: application/cbor, application/json;q=0.9" : "Accept: application/json"));
+            curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
+
+            // libcurl inflates as data arrives so the write callback only ever sees decoded bytes
+            if(m_configuration.restLink.allowCompression)
+            {
+                curl_easy_setopt(curl_handle, CURLOPT_ACCEPT_ENCODING, "");
+            }
+
+            m_downloadStats._fetches++;
+
+            cc = curl_easy_perform(curl_handle);
+
+            if(cc == CURLE_OK)
+            {
+                curl_off_t wireBytes = 0;
+                curl_easy_getinfo(curl_handle, CURLINFO_SIZE_DOWNLOAD_T, &wireBytes);
+                dcctx->_wireBytes = (uint64_t)wireBytes;
+                m_downloadStats._wireBytes += dcctx->_wireBytes;
+
+                char *contentType = nullptr;
+                curl_easy_getinfo(curl_handle, CURLINFO_CONTENT_TYPE, &contentType);
+                dcctx->_ok = decodeDeviceConfiguration(dcctx, contentType, key, limits, lastBodyHash);
+            }
+            else if(cc == CURLE_FILESIZE_EXCEEDED)
+            {
+                dcctx->_violation = ConfigurationLimits::lvBodyBytes;
+            }
+
+            if(cc != CURLE_OK || !dcctx->_ok)
+            {
+                m_downloadStats._failures++;
+            }
 
-            curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYPEER, (m_configuration.restLink.verifyPeer ? 1L : 0L));
-            curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYHOST, (m_configuration.restLink.verifyHost ? 1L : 0L));
+            if(dcctx->_violation != ConfigurationLimits::lvNone)
+            {
+                countViolation(dcctx->_violation);
+                dcctx->_body.clear();
+                dcctx->_body.shrink_to_fit();
+            }
 
-            curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, dcctx);
-            curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, curlCbDataToDeviceConfiguration);
+            curl_easy_cleanup(curl_handle);
+            curl_slist_free_all(headers);
 
-            cc = curl_easy_perform(curl_handle);
+            StringTable::Handle_t l_deviceKey = deviceKey;
 
-            curl_easy_cleanup(curl_handle);
+            dcctx->_dc.discovererKey = key;
 
-            std::string l_discovererKey = discovererKey;
+            // Encode for the cache and serialize each talkgroup once here, off the main thread, so notifications and
+            // queries only copy it (lazily decoded talkgroups do this as they're decoded)
+            if(cc == CURLE_OK && dcctx->_ok && !dcctx->_lazy && !dcctx->_identical)
+            {
+                if(!m_configuration.cache.directory.empty())
+                {
+                    nlohmann::json j = dcctx->_dc;
+                    dcctx->_cacheBody = nlohmann::json::to_cbor(j);
+                }
 
-            dcctx->_dc.discovererKey = discovererKey;
+                prepareTalkgroups(dcctx->_dc, key, dcctx->_talkgroups);
+            }
 
-            m_mainWorkQueue->submit(([cc, dcctx, l_discovererKey]()
+            m_mainWorkQueue->submit(([cc, dcctx, l_deviceKey]()
             {            
-                DeviceMap_t::iterator itr = m_devices.find(l_discovererKey);
+                DeviceMap_t::iterator itr = m_devices.find(l_deviceKey);
                 if(itr != m_devices.end())
                 {
                     DeviceTracker *dt = &itr->second;
 
-                    if(cc != CURLE_OK)
+                    if(dcctx->_violation != ConfigurationLimits::lvNone)
+                    {
+                        getLogger()->e(TAG, "configuration from %s exceeds the %s limit - ignored", dt->key().c_str(), ConfigurationLimits::describe(dcctx->_violation));
+                        dt->_wireBytes += dcctx->_wireBytes;
+                        dt->_bodyBytes += dcctx->_bodyBytes;
+                        dt->_rejectedBodies++;
+                        publishRejection(dt);
+                    }
+                    else if(cc != CURLE_OK)
                     {
-                        getLogger()->e(TAG, "curl error %d (%s) for device %s", (int)cc, curl_easy_strerror(cc), l_discovererKey.c_str());
+                        getLogger()->e(TAG, "curl error %d (%s) for device %s", (int)cc, curl_easy_strerror(cc), dt->key().c_str());
                     }
+                    else
+                    {
+                        dt->_wireBytes += dcctx->_wireBytes;
+                        dt->_bodyBytes += dcctx->_bodyBytes;
+                        if(!dcctx->_identical)
+                        {
+                            dt->_parseBytes = dcctx->_parseBytes;
+                        }
 
-                    for(std::vector<DataModel::Talkgroup>::iterator itr = dcctx->_dc.talkgroups.begin();
-                        itr != dcctx->_dc.talkgroups.end();
-                        itr++)
+                        getLogger()->d(TAG, "received %" PRIu64 " bytes (%" PRIu64 " decoded) from %s", dcctx->_wireBytes, dcctx->_bodyBytes, dt->key().c_str());
+
+                        if(dcctx->_ok && !dcctx->_identical && m_cache.isOpen())
+                        {
+                            m_cache.store(dt->key(), dt->_url, dcctx->_dc.version, dcctx->_cacheBody, dcctx->_cacheBodyIsCbor);
+                        }
+                    }
+
+                    if(cc == CURLE_OK && dcctx->_identical)
                     {
-                        itr->deviceKey.assign(l_discovererKey); 
+                        // Only skip if what we hold still came from that body - otherwise go again for real
+                        if(dt->_bodyHash == dcctx->_bodyHash)
+                        {
+                            processIdenticalBody(dt);
+                        }
+                        else
+                        {
+                            startFetch(dt);
+                        }
                     }
+                    else
+                    {
+                        // A body that can't be decoded is treated like a failed fetch rather than an empty configuration
+                        bool ok = (cc == CURLE_OK && dcctx->_ok);
+                        processDeviceConfiguration(dt->key().c_str(), dt, &dcctx->_dc, &dcctx->_talkgroups, !ok);
 
-                    processDeviceConfiguration(l_discovererKey.c_str(), dt, &dcctx->_dc, (cc == CURLE_OK) ? false : true);
+                        // The device may have been abandoned
+                        if(ok)
+                        {
+                            itr = m_devices.find(l_deviceKey);
+                            if(itr != m_devices.end())
+                            {
+                                itr->second._bodyHash = dcctx->_bodyHash;
+                            }
+                        }
+                    }
                 }
                 else
                 {
-                    getLogger()->e(TAG, "did not find device '%s' after configuration download", l_discovererKey.c_str());
+                    getLogger()->e(TAG, "did not find device '%s' after configuration download", m_strings.get(l_deviceKey).c_str());
                 }                
 
                 delete dcctx;
+                m_strings.release(l_deviceKey);
             }));
         }
 
@@ -558,11 +1870,18 @@ namespace Magellan
 
             if(strcmp(discoveryType, MAGELLAN_MDNS_DISCOVERY_TYPE) == 0 )
             {
-                #if defined(WIN32)
-                    disco = new BonjourDiscoverer();                
-                #else
-                    disco = new AvahiDiscoverer();
-                #endif
+                if(m_configuration.mdns.useNativeEngine)
+                {
+                    disco = new MdnsDiscoverer();
+                }
+                else
+                {
+                    #if defined(WIN32)
+                        disco = new BonjourDiscoverer();                
+                    #else
+                        disco = new AvahiDiscoverer();
+                    #endif
+                }
 
                 disco->configure(m_configuration.mdns);
             }
@@ -578,60 +1897,118 @@ namespace Magellan
             return disco;
         }
 
+        void removeRoute(StringTable::Handle_t discovererKey)
+        {
+            RouteIndex_t::iterator itrRoute = m_routes.find(discovererKey);
+            if(itrRoute == m_routes.end())
+            {
+                return;
+            }
+
+            StringTable::Handle_t deviceKey = itrRoute->second;
+            m_routes.erase(itrRoute);
+
+            DeviceMap_t::iterator itrDev = m_devices.find(deviceKey);
+            if(itrDev == m_devices.end())
+            {
+                m_strings.release(discovererKey);
+                return;
+            }
+
+            DeviceTracker *dt = &itrDev->second;
+            dt->_routes.erase(discovererKey);
+
+            if(dt->_routes.empty())
+            {
+                getLogger()->d(TAG, "last route to %s (%s) has gone", dt->key().c_str(), m_strings.get(discovererKey).c_str());
+                notifyOfLostDevice(dt);
+                eraseDevice(itrDev);
+            }
+            else
+            {
+                getLogger()->d(TAG, "route %s to %s has gone - %zu alternate(s) remain", m_strings.get(discovererKey).c_str(), dt->key().c_str(), dt->_routes.size());
+
+                if(dt->_activeRoute == discovererKey)
+                {
+                    dt->_activeRoute = dt->_routes.begin()->first;
+                    dt->_url = dt->_routes.begin()->second._url;
+                }
+
+                dt->updateAdvertisedVersion();
+            }
+
+            m_strings.release(discovererKey);
+        }
+
         void processDiscoveredDevice(DataModel::DiscoveredDevice *dd)
         {
             m_mainWorkQueue->submit(([dd]()
             {
-                bool needsProcessing = false;
-                DeviceMap_t::iterator itr = m_devices.find(dd->discovererKey);
+                // The same device may be seen by several discoverers - each is just another route to it.  Devices
+                // that don't advertise a Magellan ID can't be matched up so their discoverer key stands in.  The
+                // references taken here only last for this report - devices and routes hold their own.
+                StringTable::Handle_t deviceKey = m_strings.intern(dd->id.empty() ? dd->discovererKey : dd->id);
+                StringTable::Handle_t discovererKey = m_strings.intern(dd->discovererKey);
+
+                // A route that used to lead to a different device (the ID changed) gets moved
+                RouteIndex_t::iterator itrRoute = m_routes.find(discovererKey);
+                if(itrRoute != m_routes.end() && itrRoute->second != deviceKey)
+                {
+                    removeRoute(discovererKey);
+                    itrRoute = m_routes.end();
+                }
+
+                if(itrRoute == m_routes.end())
+                {
+                    m_strings.addRef(discovererKey);
+                    m_routes[discovererKey] = deviceKey;
+                }
+
+                DeviceTracker::Route_t route;
+                route._url = dd->rootUrl;
+                route._version = dd->configVersion;
+
+                DeviceMap_t::iterator itr = m_devices.find(deviceKey);
 
                 if(itr == m_devices.end())
                 {
                     DeviceTracker   dt;
 
-                    getLogger()->d(TAG, "processDiscoveredDevice %s - not found, querying", dd->serialize().c_str());
+                    getLogger()->d(TAG, "processDiscoveredDevice %s - not found", dd->serialize().c_str());
 
-                    needsProcessing = true;
-                    dt._key = dd->discovererKey;
+                    m_strings.addRef(deviceKey);
+                    dt._key = deviceKey;
                     dt._url = dd->rootUrl;
-                    dt._ps = DeviceTracker::psInProgress;
-                    m_devices[dd->discovererKey] = dt;
+                    dt._activeRoute = discovererKey;
+                    m_devices[deviceKey] = dt;
+                    itr = m_devices.find(deviceKey);
                 }
-                else
+                else if(itr->second._routes.find(discovererKey) == itr->second._routes.end())
                 {
-                    if(itr->second._cfg.version != dd->configVersion)
-                    {
-                        if(itr->second._ps != DeviceTracker::psInProgress && 
-                           itr->second._ps != DeviceTracker::psPending &&
-                           itr->second._ps != DeviceTracker::psComplete)
-                        {
-                            needsProcessing = true;
-                            itr->second._ps = DeviceTracker::psInProgress;
-                            getLogger()->d(TAG, "processDiscoveredDevice %s - new version, querying", dd->serialize().c_str());
-                        }
-                        else
-                        {
-                            getLogger()->d(TAG, "processDiscoveredDevice %s - query already in progress or completed", dd->serialize().c_str());
-                        }                        
-                    }
-                    else
-                    {
-                        getLogger()->d(TAG, "processDiscoveredDevice %s - cached version", dd->serialize().c_str());
-                    }
+                    getLogger()->d(TAG, "processDiscoveredDevice %s - alternate route to %s", dd->discovererKey.c_str(), itr->second.key().c_str());
                 }
 
-                if(needsProcessing)
+                DeviceTracker *dt = &itr->second;
+
+                // A device presented from the cache has no route until it's rediscovered - and may well have moved
+                dt->_routes[discovererKey] = route;
+                if(dt->_activeRoute == discovererKey || dt->_activeRoute == StringTable::NONE)
                 {
-                    m_downloadWorkQueue->submit(([dd]()
-                    {            
-                        doUrlDownload(dd->rootUrl.c_str(), dd->discovererKey.c_str());
-                        delete dd;
-                    }));
+                    dt->_activeRoute = discovererKey;
+                    dt->_url = dd->rootUrl;
                 }
-                else
+
+                if(dt->_provisional)
                 {
-                    delete dd;
-                }                
+                    confirmProvisionalDevice(dt);
+                }
+
+                requestFetch(dt, dt->updateAdvertisedVersion());
+
+                m_strings.release(discovererKey);
+                m_strings.release(deviceKey);
+
+                delete dd;
             }));
         }
 
@@ -643,12 +2020,8 @@ namespace Magellan
 
             m_mainWorkQueue->submit(([l_discovererKey]()
             {
-                DeviceMap_t::iterator itrDev = m_devices.find(l_discovererKey);
-                if(itrDev != m_devices.end())
-                {
-                    notifyOfLostDevice(&itrDev->second);
-                    m_devices.erase(itrDev);
-                }
+                // Never interned means never seen
+                removeRoute(m_strings.find(l_discovererKey));
             }));
         }
 
@@ -724,11 +2097,398 @@ namespace Magellan
                                      pfnOnRemovedTalkgroups,
                                      userData]()
             {
-                m_pfnOnNewTalkgroups = pfnOnNewTalkgroups;
-                m_pfnOnModifiedTalkgroups = pfnOnModifiedTalkgroups;
-                m_pfnOnRemovedTalkgroups = pfnOnRemovedTalkgroups;
-                m_pfOnTgUserData = userData;
+                if(pfnOnNewTalkgroups == nullptr && pfnOnModifiedTalkgroups == nullptr && pfnOnRemovedTalkgroups == nullptr)
+                {
+                    m_subscribers.erase(LEGACY_SUBSCRIBER_ID);
+                }
+                else
+                {
+                    Subscriber_t& sub = m_subscribers[LEGACY_SUBSCRIBER_ID];
+                    sub._filter = DataModel::TalkgroupSubscription();
+                    sub._pfnOnNew = pfnOnNewTalkgroups;
+                    sub._pfnOnModified = pfnOnModifiedTalkgroups;
+                    sub._pfnOnRemoved = pfnOnRemovedTalkgroups;
+                    sub._userData = userData;
+                }
+            }));
+        }
+
+        int subscribe(const char *filterJson,
+                      PFN_MAGELLAN_ON_NEW_TALKGROUPS pfnOnNewTalkgroups,
+                      PFN_MAGELLAN_ON_MODIFIED_TALKGROUPS pfnOnModifiedTalkgroups,
+                      PFN_MAGELLAN_ON_REMOVED_TALKGROUPS pfnOnRemovedTalkgroups,
+                      const void *userData,
+                      MagellanToken_t *pToken)
+        {
+            if(!m_initialized)
+            {
+                return MAGELLAN_RESULT_NOT_INITIALIZED;
+            }
+
+            if(pToken == nullptr)
+            {
+                return MAGELLAN_RESULT_INVALID_PARAMETERS;
+            }
+
+            Subscriber_t sub;
+
+            try
+            {
+                if(filterJson != nullptr && filterJson[0] != 0)
+                {
+                    nlohmann::json j = nlohmann::json::parse(filterJson);
+                    sub._filter = j.get<DataModel::TalkgroupSubscription>();
+                }
+            }
+            catch(...)
+            {
+                getLogger()->e(TAG, "subscribe - invalid filter");
+                return MAGELLAN_RESULT_INVALID_PARAMETERS;
+            }
+
+            sub._pfnOnNew = pfnOnNewTalkgroups;
+            sub._pfnOnModified = pfnOnModifiedTalkgroups;
+            sub._pfnOnRemoved = pfnOnRemovedTalkgroups;
+            sub._userData = userData;
+
+            uint64_t id = m_nextSubscriberId++;
+            *pToken = (MagellanToken_t)(uintptr_t)id;
+
+            getLogger()->d(TAG, "subscribe %" PRIu64, id);
+
+            m_mainWorkQueue->submit(([id, sub]()
+            {
+                m_subscribers[id] = sub;
+            }));
+
+            return MAGELLAN_RESULT_OK;
+        }
+
+        int unsubscribe(MagellanToken_t token)
+        {
+            if(!m_initialized)
+            {
+                return MAGELLAN_RESULT_NOT_INITIALIZED;
+            }
+
+            uint64_t id = (uint64_t)(uintptr_t)token;
+
+            if(id == LEGACY_SUBSCRIBER_ID)
+            {
+                return MAGELLAN_RESULT_INVALID_PARAMETERS;
+            }
+
+            getLogger()->d(TAG, "unsubscribe %" PRIu64, id);
+
+            m_mainWorkQueue->submit(([id]()
+            {
+                m_subscribers.erase(id);
+            }));
+
+            return MAGELLAN_RESULT_OK;
+        }
+
+        void setTalkgroupViewCallbacks(PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnNewTalkgroupViews,
+                                       PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnModifiedTalkgroupViews,
+                                       PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnRemovedTalkgroupViews,
+                                       const void *userData)
+        {
+            m_mainWorkQueue->submit(([pfnOnNewTalkgroupViews,
+                                     pfnOnModifiedTalkgroupViews,
+                                     pfnOnRemovedTalkgroupViews,
+                                     userData]()
+            {
+                m_pfnOnNewTalkgroupViews = pfnOnNewTalkgroupViews;
+                m_pfnOnModifiedTalkgroupViews = pfnOnModifiedTalkgroupViews;
+                m_pfnOnRemovedTalkgroupViews = pfnOnRemovedTalkgroupViews;
+                m_pfOnTgViewUserData = userData;
             }));
         }
+
+        int getTalkgroup(const char *id, std::string& json)
+        {
+            if(!m_initialized)
+            {
+                return MAGELLAN_RESULT_NOT_INITIALIZED;
+            }
+
+            std::shared_ptr<const TalkgroupRegistry> snap = loadSnapshot();
+            TalkgroupRegistry::TalkgroupPtr tg;
+
+            if(snap)
+            {
+                tg = snap->get(id);
+            }
+
+            if(!tg)
+            {
+                return MAGELLAN_RESULT_NOT_FOUND;
+            }
+
+            json.clear();
+            tg->appendJson(json);
+
+            return MAGELLAN_RESULT_OK;
+        }
+
+        int queryTalkgroups(const char *filterJson, std::string& json)
+        {
+            if(!m_initialized)
+            {
+                return MAGELLAN_RESULT_NOT_INITIALIZED;
+            }
+
+            DataModel::TalkgroupQuery q;
+            if(filterJson != nullptr && filterJson[0] != 0 && !q.deserialize(filterJson))
+            {
+                getLogger()->e(TAG, "invalid talkgroup query '%s'", filterJson);
+                return MAGELLAN_RESULT_INVALID_PARAMETERS;
+            }
+
+            std::shared_ptr<const TalkgroupRegistry> snap = loadSnapshot();
+            TalkgroupRegistry::TalkgroupList_t results;
+
+            if(snap)
+            {
+                snap->query(q, results);
+            }
+
+            json.clear();
+            for(TalkgroupRegistry::TalkgroupList_t::iterator itr = results.begin();
+                itr != results.end();
+                itr++)
+            {
+                appendToJsonArray(json, *(*itr));
+            }
+
+            json.append(json.empty() ? "[]" : "]");
+
+            return MAGELLAN_RESULT_OK;
+        }
+
+        int getDevices(std::string& json)
+        {
+            if(!m_initialized)
+            {
+                return MAGELLAN_RESULT_NOT_INITIALIZED;
+            }
+
+            std::shared_ptr<const TalkgroupRegistry> snap = loadSnapshot();
+
+            nlohmann::json j;
+            nlohmann::json devArray = nlohmann::json::array();
+
+            if(snap)
+            {
+                for(TalkgroupRegistry::DeviceMap_t::const_iterator itr = snap->getDevices().begin();
+                    itr != snap->getDevices().end();
+                    itr++)
+                {
+                    nlohmann::json dev;
+                    dev["deviceKey"] = itr->first;
+                    dev["url"] = itr->second._url;
+                    dev["version"] = itr->second._configVersion;
+                    dev["wireBytes"] = itr->second._wireBytes;
+                    dev["bodyBytes"] = itr->second._bodyBytes;
+                    dev["heldBytes"] = itr->second._heldBytes;
+                    dev["rejectedBodies"] = itr->second._rejectedBodies;
+                    dev["provisional"] = itr->second._provisional;
+                    devArray.push_back(dev);
+                }
+            }
+
+            j["snapshotVersion"] = (snap ? snap->getVersion() : 0);
+            j["devices"] = devArray;
+            json = j.dump();
+
+            return MAGELLAN_RESULT_OK;
+        }
+
+        int getChangesSince(uint64_t seq, std::string& json)
+        {
+            if(!m_initialized)
+            {
+                return MAGELLAN_RESULT_NOT_INITIALIZED;
+            }
+
+            nlohmann::json j;
+            ChangeJournal::EntryList_t entries;
+            uint64_t lastSeq = 0;
+            std::string arr;
+
+            if(m_journal.changesSince(seq, entries, lastSeq))
+            {
+                for(ChangeJournal::EntryList_t::iterator itr = entries.begin();
+                    itr != entries.end();
+                    itr++)
+                {
+                    nlohmann::json c;
+                    c["seq"] = itr->_seq;
+                    c["op"] = (itr->_op == ChangeJournal::opAdd ? "add" : (itr->_op == ChangeJournal::opModify ? "modify" : "remove"));
+                    c["id"] = itr->_id;
+                    c["deviceKey"] = itr->_deviceKey;
+
+                    std::string entry = c.dump();
+                    if(itr->_tg)
+                    {
+                        std::string tgJson;
+                        itr->_tg->appendJson(tgJson);
+                        spliceJsonMember(entry, "talkgroup", tgJson);
+                    }
+
+                    appendToJsonArray(arr, entry);
+                }
+
+                j["full"] = false;
+                j["sequence"] = lastSeq;
+            }
+            else
+            {
+                // The journal can't cover the gap so hand back everything as at the snapshot's sequence
+                std::shared_ptr<const TalkgroupRegistry> snap = loadSnapshot();
+                TalkgroupRegistry::TalkgroupList_t results;
+                DataModel::TalkgroupQuery q;
+
+                if(snap)
+                {
+                    snap->query(q, results);
+                }
+
+                for(TalkgroupRegistry::TalkgroupList_t::iterator itr = results.begin();
+                    itr != results.end();
+                    itr++)
+                {
+                    appendToJsonArray(arr, *(*itr));
+                }
+
+                j["full"] = true;
+                j["sequence"] = (snap ? snap->getSequence() : 0);
+            }
+
+            arr.append(arr.empty() ? "[]" : "]");
+
+            json = j.dump();
+            spliceJsonMember(json, (j["full"].get<bool>() ? "talkgroups" : "changes"), arr);
+
+            return MAGELLAN_RESULT_OK;
+        }
+
+        int getStats(std::string& json)
+        {
+            if(!m_initialized)
+            {
+                return MAGELLAN_RESULT_NOT_INITIALIZED;
+            }
+
+            nlohmann::json j;
+
+            uint64_t delivered = m_callbackStats._delivered;
+
+            nlohmann::json cb;
+            cb["delivered"] = delivered;
+            cb["dropped"] = (uint64_t)m_callbackStats._dropped;
+            cb["slow"] = (uint64_t)m_callbackStats._slow;
+            cb["totalMs"] = (uint64_t)m_callbackStats._totalMs;
+            cb["maxMs"] = (uint64_t)m_callbackStats._maxMs;
+            cb["averageMs"] = (delivered > 0 ? ((double)m_callbackStats._totalMs / (double)delivered) : 0.0);
+            j["callbacks"] = cb;
+
+            nlohmann::json dl;
+            dl["fetches"] = (uint64_t)m_downloadStats._fetches;
+            dl["failures"] = (uint64_t)m_downloadStats._failures;
+            dl["bytes"] = (uint64_t)m_downloadStats._bytes;
+            dl["wireBytes"] = (uint64_t)m_downloadStats._wireBytes;
+            dl["cborBodies"] = (uint64_t)m_downloadStats._cborBodies;
+            dl["jsonBodies"] = (uint64_t)m_downloadStats._jsonBodies;
+            dl["lazyBodies"] = (uint64_t)m_downloadStats._lazyBodies;
+            dl["identicalBodies"] = (uint64_t)m_downloadStats._identicalBodies;
+            dl["decodeUs"] = (uint64_t)m_downloadStats._decodeUs;
+            j["downloads"] = dl;
+
+            nlohmann::json limits;
+            limits["bodyBytes"] = (uint64_t)m_downloadStats._overBodyBytes;
+            limits["talkgroups"] = (uint64_t)m_downloadStats._overTalkgroups;
+            limits["rallypoints"] = (uint64_t)m_downloadStats._overRallypoints;
+            limits["stringLength"] = (uint64_t)m_downloadStats._overStringLength;
+            j["limits"] = limits;
+
+            // What each device costs to hold, as at the current snapshot
+            std::shared_ptr<const TalkgroupRegistry> snap = loadSnapshot();
+            nlohmann::json devices = nlohmann::json::object();
+            uint64_t heldBytes = 0;
+
+            if(snap)
+            {
+                for(TalkgroupRegistry::DeviceMap_t::const_iterator itr = snap->getDevices().begin();
+                    itr != snap->getDevices().end();
+                    itr++)
+                {
+                    nlohmann::json dev;
+                    dev["heldBytes"] = itr->second._heldBytes;
+                    dev["parseBytes"] = itr->second._parseBytes;
+                    dev["rejectedBodies"] = itr->second._rejectedBodies;
+                    devices[itr->first] = dev;
+                    heldBytes += itr->second._heldBytes;
+                }
+            }
+
+            nlohmann::json memory;
+            memory["heldBytes"] = heldBytes;
+            memory["devices"] = devices;
+            j["memory"] = memory;
+
+            LazyTalkgroup::Stats_t ls;
+            LazyTalkgroup::getStats(ls);
+
+            nlohmann::json lazy;
+            lazy["encoded"] = ls._encoded;
+            lazy["decoded"] = ls._decoded;
+            lazy["failed"] = ls._failed;
+            j["lazyTalkgroups"] = lazy;
+
+            ContentStore::Stats_t cs;
+            m_contentStore.getStats(cs);
+
+            nlohmann::json content;
+            content["talkgroups"] = (uint64_t)cs._talkgroups;
+            content["configurations"] = (uint64_t)cs._configurations;
+            content["lookups"] = cs._lookups;
+            content["hits"] = cs._hits;
+            j["content"] = content;
+
+            nlohmann::json strings;
+            strings["count"] = (uint64_t)m_strings.size();
+            strings["bytes"] = (uint64_t)m_strings.bytes();
+            strings["released"] = m_strings.released();
+            j["strings"] = strings;
+
+            ParseArena::Stats_t as;
+            m_parseArena.getStats(as);
+
+            nlohmann::json arena;
+            arena["allocations"] = as._allocations;
+            arena["bytes"] = as._bytes;
+            arena["peakBytes"] = as._peakBytes;
+            arena["blocks"] = as._blocks;
+            arena["resets"] = as._resets;
+            j["parseArena"] = arena;
+
+            json = j.dump();
+
+            return MAGELLAN_RESULT_OK;
+        }
+
+        int getSnapshotVersion(uint64_t *pVersion)
+        {
+            if(!m_initialized)
+            {
+                return MAGELLAN_RESULT_NOT_INITIALIZED;
+            }
+
+            std::shared_ptr<const TalkgroupRegistry> snap = loadSnapshot();
+            *pVersion = (snap ? snap->getVersion() : 0);
+
+            return MAGELLAN_RESULT_OK;
+        }
     }
 }
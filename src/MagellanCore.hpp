@@ -37,6 +37,26 @@ namespace Magellan
                                    PFN_MAGELLAN_ON_MODIFIED_TALKGROUPS pfnOnModifiedTalkgroups,
                                    PFN_MAGELLAN_ON_REMOVED_TALKGROUPS pfnOnRemovedTalkgroups,
                                    const void *userData);
+
+        void setTalkgroupViewCallbacks(PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnNewTalkgroupViews,
+                                       PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnModifiedTalkgroupViews,
+                                       PFN_MAGELLAN_ON_TALKGROUP_VIEWS pfnOnRemovedTalkgroupViews,
+                                       const void *userData);
+
+        int subscribe(const char *filterJson,
+                      PFN_MAGELLAN_ON_NEW_TALKGROUPS pfnOnNewTalkgroups,
+                      PFN_MAGELLAN_ON_MODIFIED_TALKGROUPS pfnOnModifiedTalkgroups,
+                      PFN_MAGELLAN_ON_REMOVED_TALKGROUPS pfnOnRemovedTalkgroups,
+                      const void *userData,
+                      MagellanToken_t *pToken);
+        int unsubscribe(MagellanToken_t token);
+
+        int getTalkgroup(const char *id, std::string& json);
+        int queryTalkgroups(const char *filterJson, std::string& json);
+        int getDevices(std::string& json);
+        int getSnapshotVersion(uint64_t *pVersion);
+        int getStats(std::string& json);
+        int getChangesSince(uint64_t seq, std::string& json);
     }
 }
 #endif
@@ -8,6 +8,13 @@
 
 #include <stdio.h>
 #include <iostream>
+#include <algorithm>
+#include <memory>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "nlohmann/json.hpp"
 
 namespace Magellan
@@ -129,14 +136,90 @@ namespace Magellan
             return fp;
         }
 
+        /**
+         * @brief Cheap check of whether a JSON value can be converted to T
+         *
+         * Lets getOptional() skip values that would otherwise only be rejected by nlohmann throwing - which is
+         * expensive when gateways routinely leave out optional members.  Class types are expected to be objects.
+         * Works with any nlohmann::basic_json type.
+         */
+        template<class T, class Enable = void>
+        struct JsonTypeCheck
+        {
+            template<class J>
+            static bool compatible(const J& j)
+            {
+                return j.is_object();
+            }
+        };
+
+        template<>
+        struct JsonTypeCheck<std::string>
+        {
+            template<class J>
+            static bool compatible(const J& j)
+            {
+                return j.is_string();
+            }
+        };
+
+        template<>
+        struct JsonTypeCheck<bool>
+        {
+            template<class J>
+            static bool compatible(const J& j)
+            {
+                return j.is_boolean();
+            }
+        };
+
         template<class T>
-        static void getOptional(const char *name, T& v, const nlohmann::json& j, T def)
+        struct JsonTypeCheck<T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type>
+        {
+            template<class J>
+            static bool compatible(const J& j)
+            {
+                return (j.is_number() || j.is_boolean());
+            }
+        };
+
+        template<class T>
+        struct JsonTypeCheck<std::vector<T>>
+        {
+            template<class J>
+            static bool compatible(const J& j)
+            {
+                return j.is_array();
+            }
+        };
+
+        template<class T, class J>
+        static bool getIfPresent(const char *name, T& v, const J& j)
         {
+            // find() doesn't throw - it simply returns end() if j is not an object
+            typename J::const_iterator itr = j.find(name);
+            if(itr == j.end() || !JsonTypeCheck<T>::compatible(*itr))
+            {
+                return false;
+            }
+
+            // Only something unusual deeper inside (such as a number in an array of strings) can still throw
             try
             {
-                j.at(name).get_to(v);
+                itr->get_to(v);
             }
             catch(...)
+            {
+                return false;
+            }
+
+            return true;
+        }
+
+        template<class T>
+        static void getOptional(const char *name, T& v, const nlohmann::json& j, T def)
+        {
+            if(!getIfPresent(name, v, j))
             {
                 v = def;
             }
@@ -145,14 +228,251 @@ namespace Magellan
         template<class T>
         static void getOptional(const char *name, T& v, const nlohmann::json& j)
         {
-            try
+            getIfPresent(name, v, j);
+        }        
+
+        /**
+         * @brief Describes one serialized member of a class
+         *
+         * Classes list their members once, in a static describe() template, by passing a descriptor for each to
+         * a visitor.  The visitors below then provide to_json, from_json, equality and hashing for the class so
+         * that adding a member is a one-line change.  Everything resolves at compile time.
+         */
+        template<class C, class T>
+        struct FieldDescriptor
+        {
+            const char  *name;
+            T C::*      member;
+        };
+
+        template<class C, class T>
+        static inline FieldDescriptor<C, T> describeField(const char *name, T C::*member)
+        {
+            return FieldDescriptor<C, T>{name, member};
+        }
+
+        #define DESCRIBE_FIELD(__cls, __var) \
+            describeField(#__var, &__cls::__var)
+
+        /** @brief True if T lists its members with describe() **/
+        template<class T>
+        struct HasFieldDescriptors
+        {
+            struct Probe
             {
-                j.at(name).get_to(v);
+                template<class C, class M>
+                void operator()(const FieldDescriptor<C, M>&)
+                {
+                }
+            };
+
+            template<class U>
+            static char test(decltype(U::describe(std::declval<Probe&>()))*);
+
+            template<class U>
+            static long test(...);
+
+            static const bool value = (sizeof(test<T>(nullptr)) == sizeof(char));
+        };
+
+        template<class C>
+        static bool fieldsMatch(const C& a, const C& b);
+
+        template<class C>
+        static size_t fieldsHash(const C& p);
+
+        template<class T>
+        static typename std::enable_if<HasFieldDescriptors<T>::value, bool>::type fieldEquals(const T& a, const T& b)
+        {
+            return fieldsMatch(a, b);
+        }
+
+        template<class T>
+        static typename std::enable_if<!HasFieldDescriptors<T>::value, bool>::type fieldEquals(const T& a, const T& b)
+        {
+            return (a == b);
+        }
+
+        template<class T>
+        static bool fieldEquals(const std::vector<T>& a, const std::vector<T>& b)
+        {
+            if(a.size() != b.size())
+            {
+                return false;
             }
-            catch(...)
+
+            for(size_t x = 0; x < a.size(); x++)
             {
+                if(!fieldEquals(a[x], b[x]))
+                {
+                    return false;
+                }
             }
-        }        
+
+            return true;
+        }
+
+        static inline void hashCombine(size_t& h, size_t v)
+        {
+            h ^= (v + 0x9e3779b9 + (h << 6) + (h >> 2));
+        }
+
+        template<class T>
+        static typename std::enable_if<HasFieldDescriptors<T>::value, size_t>::type fieldHash(const T& v)
+        {
+            return fieldsHash(v);
+        }
+
+        template<class T>
+        static typename std::enable_if<!HasFieldDescriptors<T>::value, size_t>::type fieldHash(const T& v)
+        {
+            return std::hash<T>()(v);
+        }
+
+        template<class T>
+        static size_t fieldHash(const std::vector<T>& v)
+        {
+            size_t h = v.size();
+            for(size_t x = 0; x < v.size(); x++)
+            {
+                hashCombine(h, fieldHash(v[x]));
+            }
+            return h;
+        }
+
+        template<class C>
+        class FieldWriter
+        {
+        public:
+            FieldWriter(const C& p, nlohmann::json& j) : _p(p), _j(j)
+            {
+            }
+
+            template<class T>
+            void operator()(const FieldDescriptor<C, T>& f)
+            {
+                _j[f.name] = (_p.*(f.member));
+            }
+
+        private:
+            const C&            _p;
+            nlohmann::json&     _j;
+        };
+
+        template<class C, class J = nlohmann::json>
+        class FieldReader
+        {
+        public:
+            FieldReader(C& p, const J& j) : _p(p), _j(j)
+            {
+            }
+
+            // Members that are absent or unusable keep the value given to them by clear()
+            template<class T>
+            void operator()(const FieldDescriptor<C, T>& f)
+            {
+                getIfPresent(f.name, (_p.*(f.member)), _j);
+            }
+
+        private:
+            C&                      _p;
+            const J&                _j;
+        };
+
+        template<class C>
+        class FieldMatcher
+        {
+        public:
+            FieldMatcher(const C& a, const C& b) : _a(a), _b(b), _result(true)
+            {
+            }
+
+            template<class T>
+            void operator()(const FieldDescriptor<C, T>& f)
+            {
+                _result = (_result && fieldEquals((_a.*(f.member)), (_b.*(f.member))));
+            }
+
+            inline bool result() const
+            {
+                return _result;
+            }
+
+        private:
+            const C&    _a;
+            const C&    _b;
+            bool        _result;
+        };
+
+        template<class C>
+        class FieldHasher
+        {
+        public:
+            explicit FieldHasher(const C& p) : _p(p), _hash(0)
+            {
+            }
+
+            template<class T>
+            void operator()(const FieldDescriptor<C, T>& f)
+            {
+                hashCombine(_hash, fieldHash(_p.*(f.member)));
+            }
+
+            inline size_t result() const
+            {
+                return _hash;
+            }
+
+        private:
+            const C&    _p;
+            size_t      _hash;
+        };
+
+        template<class C>
+        static void fieldsToJson(nlohmann::json& j, const C& p)
+        {
+            j = nlohmann::json::object();
+            FieldWriter<C> w(p, j);
+            C::describe(w);
+        }
+
+        template<class C, class J>
+        static void fieldsFromJson(const J& j, C& p)
+        {
+            p.clear();
+            FieldReader<C, J> r(p, j);
+            C::describe(r);
+        }
+
+        /**
+         * @brief from_json for described classes held in documents other than nlohmann::json
+         *
+         * Lets a document built with a different allocator (see ParseArena) be read directly rather than first
+         * being converted - an exact match, so it's preferred over the nlohmann::json overloads.
+         */
+        template<class J, class C>
+        static typename std::enable_if<HasFieldDescriptors<C>::value &&
+                                       nlohmann::detail::is_basic_json<J>::value &&
+                                       !std::is_same<J, nlohmann::json>::value>::type from_json(const J& j, C& p)
+        {
+            fieldsFromJson(j, p);
+        }
+
+        template<class C>
+        static bool fieldsMatch(const C& a, const C& b)
+        {
+            FieldMatcher<C> m(a, b);
+            C::describe(m);
+            return m.result();
+        }
+
+        template<class C>
+        static size_t fieldsHash(const C& p)
+        {
+            FieldHasher<C> h(p);
+            C::describe(h);
+            return h.result();
+        }
 
 
         //-----------------------------------------------------------
@@ -215,6 +535,14 @@ namespace Magellan
              */
             int                                     port;
 
+            /** @brief Serialized members - these drive serialization, deserialization and comparison */
+            template<class V>
+            static void describe(V& v)
+            {
+                v(DESCRIBE_FIELD(NetworkAddress, address));
+                v(DESCRIBE_FIELD(NetworkAddress, port));
+            }
+
             NetworkAddress()
             {
                 clear();
@@ -228,17 +556,13 @@ namespace Magellan
 
             virtual bool matches(NetworkAddress& other)
             {
-                return ( address.compare(other.address) == 0 &&
-                        port == other.port );
+                return fieldsMatch(*this, other);
             }
         };
 
         static void to_json(nlohmann::json& j, const NetworkAddress& p)
         {
-            j = nlohmann::json{
-                TOJSON_IMPL(address),
-                TOJSON_IMPL(port)
-            };
+            fieldsToJson(j, p);
         }
 
         class SsdpNetworkAddress : public NetworkAddress
@@ -264,9 +588,7 @@ namespace Magellan
 
         static void from_json(const nlohmann::json& j, NetworkAddress& p)
         {
-            p.clear();
-            FROMJSON_IMPL(address, std::string, EMPTY_STRING);
-            FROMJSON_IMPL(port, int, 0);
+            fieldsFromJson(j, p);
         }
 
         //-----------------------------------------------------------
@@ -407,6 +729,31 @@ namespace Magellan
              */
             std::string                     serviceType;
 
+            /**
+             * @brief Use the built-in mDNS querier rather than the platform's service (Avahi/Bonjour)
+             */
+            bool                            useNativeEngine;
+
+            /**
+             * @brief Initial interval (in milliseconds) between continuous queries (native engine only)
+             */
+            unsigned long                   queryIntervalMs;
+
+            /**
+             * @brief Ceiling (in milliseconds) that the query interval backs off to (native engine only)
+             */
+            unsigned long                   maxQueryIntervalMs;
+
+            /**
+             * @brief Also query over IPv6 on ff02::fb (native engine only)
+             */
+            bool                            enableIpv6;
+
+            /**
+             * @brief Receive multicast sent from this host - allows testing over loopback (native engine only)
+             */
+            bool                            enableLoopback;
+
             Mdns()
             {
             }
@@ -414,6 +761,11 @@ namespace Magellan
             virtual void clear()
             {
                 serviceType.clear();
+                useNativeEngine = false;
+                queryIntervalMs = 1000;
+                maxQueryIntervalMs = 60000;
+                enableIpv6 = true;
+                enableLoopback = true;
                 setDefaultsIfNecessary();
             }
 
@@ -423,13 +775,28 @@ namespace Magellan
                 {
                     serviceType.assign("_magellan._tcp");
                 }
+
+                if(queryIntervalMs <= 0)
+                {
+                    queryIntervalMs = 1000;
+                }
+
+                if(maxQueryIntervalMs < queryIntervalMs)
+                {
+                    maxQueryIntervalMs = queryIntervalMs;
+                }
             }
         };
 
         static void to_json(nlohmann::json& j, const Mdns& p)
         {
             j = nlohmann::json{
-                TOJSON_IMPL(serviceType)
+                TOJSON_IMPL(serviceType),
+                TOJSON_IMPL(useNativeEngine),
+                TOJSON_IMPL(queryIntervalMs),
+                TOJSON_IMPL(maxQueryIntervalMs),
+                TOJSON_IMPL(enableIpv6),
+                TOJSON_IMPL(enableLoopback)
             };
         }
 
@@ -437,6 +804,11 @@ namespace Magellan
         {
             p.clear();
             FROMJSON_IMPL_SIMPLE(serviceType);
+            FROMJSON_IMPL(useNativeEngine, bool, false);
+            FROMJSON_IMPL(queryIntervalMs, unsigned long, 1000);
+            FROMJSON_IMPL(maxQueryIntervalMs, unsigned long, 60000);
+            FROMJSON_IMPL(enableIpv6, bool, true);
+            FROMJSON_IMPL(enableLoopback, bool, true);
             p.setDefaultsIfNecessary();
         }
 
@@ -515,6 +887,41 @@ namespace Magellan
              * @brief Log detail of URL operations
              */
             bool                        logUrlOperation;
+
+            /**
+             * @brief Ask devices for CBOR-encoded configuration (devices that don't support it respond with JSON)
+             */
+            bool                        acceptCbor;
+
+            /**
+             * @brief Let devices compress configuration (any content encoding supported by libcurl - gzip, deflate, zstd, etc)
+             */
+            bool                        allowCompression;
+
+            /**
+             * @brief Configurations with at least this many talkgroups have each decoded only when it's first needed (0 to always decode everything)
+             */
+            unsigned long               lazyTalkgroupThreshold;
+
+            /**
+             * @brief Largest decoded configuration body accepted from a device - the download is abandoned as soon as it's exceeded (0 for no limit)
+             */
+            unsigned long               maxBodyBytes;
+
+            /**
+             * @brief Most talkgroups accepted in a device's configuration (0 for no limit)
+             */
+            unsigned long               maxTalkgroups;
+
+            /**
+             * @brief Most rallypoints accepted for any one talkgroup (0 for no limit)
+             */
+            unsigned long               maxRallypointsPerTalkgroup;
+
+            /**
+             * @brief Longest string (name or value) accepted anywhere in a device's configuration (0 for no limit)
+             */
+            unsigned long               maxStringLength;
             
 
 
@@ -537,6 +944,13 @@ namespace Magellan
                 maxUrlConsecutiveErrors = 50;
                 abandonUrlsAfterConsecutiveErrors = false;
                 logUrlOperation = false;
+                acceptCbor = true;
+                allowCompression = true;
+                lazyTalkgroupThreshold = 1000;
+                maxBodyBytes = 16777216;
+                maxTalkgroups = 0;
+                maxRallypointsPerTalkgroup = 0;
+                maxStringLength = 0;
             }
         };
 
@@ -554,7 +968,14 @@ namespace Magellan
                 TOJSON_IMPL(urlRetryIntervalMs),
                 TOJSON_IMPL(maxUrlConsecutiveErrors),
                 TOJSON_IMPL(abandonUrlsAfterConsecutiveErrors),
-                TOJSON_IMPL(logUrlOperation)
+                TOJSON_IMPL(logUrlOperation),
+                TOJSON_IMPL(acceptCbor),
+                TOJSON_IMPL(allowCompression),
+                TOJSON_IMPL(lazyTalkgroupThreshold),
+                TOJSON_IMPL(maxBodyBytes),
+                TOJSON_IMPL(maxTalkgroups),
+                TOJSON_IMPL(maxRallypointsPerTalkgroup),
+                TOJSON_IMPL(maxStringLength)
             };
         }
 
@@ -575,6 +996,163 @@ namespace Magellan
             FROMJSON_IMPL(maxUrlConsecutiveErrors, unsigned long, 50);
             FROMJSON_IMPL(abandonUrlsAfterConsecutiveErrors, bool, false);
             FROMJSON_IMPL(logUrlOperation, bool, false);
+            FROMJSON_IMPL(acceptCbor, bool, true);
+            FROMJSON_IMPL(allowCompression, bool, true);
+            FROMJSON_IMPL(lazyTalkgroupThreshold, unsigned long, 1000);
+            FROMJSON_IMPL(maxBodyBytes, unsigned long, 16777216);
+            FROMJSON_IMPL(maxTalkgroups, unsigned long, 0);
+            FROMJSON_IMPL(maxRallypointsPerTalkgroup, unsigned long, 0);
+            FROMJSON_IMPL(maxStringLength, unsigned long, 0);
+        }
+
+
+        //-----------------------------------------------------------
+        JSON_SERIALIZED_CLASS(Notifications)
+        /**
+        * @brief Helper class for serializing and deserializing the Notifications JSON
+        *
+        * Controls how talkgroup changes are delivered to the application.  With a coalescing window, changes
+        * from all devices are merged and delivered as one batch per type when the window closes (or sooner if
+        * maxCoalescedChanges is reached).  Changes that cancel out within a window (an add then a remove) are
+        * not delivered at all.
+        *
+        * Example: @include[doc] examples/Notifications.json
+        */
+        class Notifications : public JsonObjectBase
+        {
+            IMPLEMENT_JSON_SERIALIZATION()
+            IMPLEMENT_JSON_DOCUMENTATION(Notifications)
+
+        public:
+            /**
+             * @brief Milliseconds over which changes are coalesced (0 delivers each device's changes immediately)
+             */
+            unsigned long               coalesceWindowMs;
+
+            /**
+             * @brief Number of pending changes that causes delivery before the window closes
+             */
+            unsigned long               maxCoalescedChanges;
+
+            /**
+             * @brief Maximum number of callback deliveries queued for the application before new ones are dropped
+             */
+            unsigned long               maxQueuedCallbacks;
+
+            /**
+             * @brief A warning is logged when an application callback takes longer than this
+             */
+            unsigned long               slowCallbackWarningMs;
+
+            /**
+             * @brief Number of talkgroup changes retained for consumers catching up with magellanGetChangesSince()
+             */
+            unsigned long               journalSize;
+
+            /**
+             * @brief Deliver modifications as JSON Patch deltas against the previous version rather than full talkgroups
+             */
+            bool                        modifiedDeltas;
+
+            Notifications()
+            {
+                clear();
+            }
+
+            virtual void clear()
+            {
+                coalesceWindowMs = 0;
+                maxCoalescedChanges = 1000;
+                maxQueuedCallbacks = 512;
+                slowCallbackWarningMs = 100;
+                journalSize = 4096;
+                modifiedDeltas = false;
+            }
+        };
+
+        static void to_json(nlohmann::json& j, const Notifications& p)
+        {
+            j = nlohmann::json{
+                TOJSON_IMPL(coalesceWindowMs),
+                TOJSON_IMPL(maxCoalescedChanges),
+                TOJSON_IMPL(maxQueuedCallbacks),
+                TOJSON_IMPL(slowCallbackWarningMs),
+                TOJSON_IMPL(journalSize),
+                TOJSON_IMPL(modifiedDeltas)
+            };
+        }
+
+        static void from_json(const nlohmann::json& j, Notifications& p)
+        {
+            p.clear();
+            FROMJSON_IMPL(coalesceWindowMs, unsigned long, 0);
+            FROMJSON_IMPL(maxCoalescedChanges, unsigned long, 1000);
+            FROMJSON_IMPL(maxQueuedCallbacks, unsigned long, 512);
+            FROMJSON_IMPL(slowCallbackWarningMs, unsigned long, 100);
+            FROMJSON_IMPL(journalSize, unsigned long, 4096);
+            FROMJSON_IMPL(modifiedDeltas, bool, false);
+        }
+
+
+        //-----------------------------------------------------------
+        JSON_SERIALIZED_CLASS(Cache)
+        /**
+        * @brief Helper class for serializing and deserializing the Cache JSON
+        *
+        * Persistent store of device configurations so that a restart doesn't mean downloading everything
+        * again.  Disabled unless a directory is given.
+        *
+        * Example: @include[doc] examples/Cache.json
+        */
+        class Cache : public JsonObjectBase
+        {
+            IMPLEMENT_JSON_SERIALIZATION()
+            IMPLEMENT_JSON_DOCUMENTATION(Cache)
+
+        public:
+            /**
+             * @brief Directory holding the cache file (empty to disable caching)
+             */
+            std::string                 directory;
+
+            /**
+             * @brief Present cached talkgroups at startup, before their devices have been rediscovered
+             */
+            bool                        provisionalAtStartup;
+
+            /**
+             * @brief Milliseconds a provisional device is kept if it isn't rediscovered
+             */
+            unsigned long               provisionalLifetimeMs;
+
+            Cache()
+            {
+                clear();
+            }
+
+            virtual void clear()
+            {
+                directory.clear();
+                provisionalAtStartup = false;
+                provisionalLifetimeMs = 60000;
+            }
+        };
+
+        static void to_json(nlohmann::json& j, const Cache& p)
+        {
+            j = nlohmann::json{
+                TOJSON_IMPL(directory),
+                TOJSON_IMPL(provisionalAtStartup),
+                TOJSON_IMPL(provisionalLifetimeMs)
+            };
+        }
+
+        static void from_json(const nlohmann::json& j, Cache& p)
+        {
+            p.clear();
+            FROMJSON_IMPL(directory, std::string, EMPTY_STRING);
+            FROMJSON_IMPL(provisionalAtStartup, bool, false);
+            FROMJSON_IMPL(provisionalLifetimeMs, unsigned long, 60000);
         }
 
 
@@ -613,6 +1191,16 @@ namespace Magellan
              */
             Ssdp                        ssdp;
 
+            /**
+             * @brief Notification delivery
+             */
+            Notifications               notifications;
+
+            /**
+             * @brief Persistent configuration cache
+             */
+            Cache                       cache;
+
             MagellanConfiguration()
             {
                 clear();
@@ -624,6 +1212,8 @@ namespace Magellan
                 restLink.clear();
                 ssdp.clear();
                 mdns.clear();
+                notifications.clear();
+                cache.clear();
             }
         };
 
@@ -633,7 +1223,9 @@ namespace Magellan
                 TOJSON_IMPL(houseKeeperIntervalMs),
                 TOJSON_IMPL(restLink),
                 TOJSON_IMPL(ssdp),
-                TOJSON_IMPL(mdns)
+                TOJSON_IMPL(mdns),
+                TOJSON_IMPL(notifications),
+                TOJSON_IMPL(cache)
             };
         }
 
@@ -644,6 +1236,8 @@ namespace Magellan
             FROMJSON_IMPL_SIMPLE(restLink);
             FROMJSON_IMPL_SIMPLE(ssdp);
             FROMJSON_IMPL_SIMPLE(mdns);
+            FROMJSON_IMPL_SIMPLE(notifications);
+            FROMJSON_IMPL_SIMPLE(cache);
         }
 
 
@@ -759,6 +1353,16 @@ namespace Magellan
              */
             std::vector<std::string>                capabilities;
 
+            /** @brief Serialized members - these drive serialization, deserialization and comparison */
+            template<class V>
+            static void describe(V& v)
+            {
+                v(DESCRIBE_FIELD(ThingInfo, id));
+                v(DESCRIBE_FIELD(ThingInfo, type));
+                v(DESCRIBE_FIELD(ThingInfo, manufacturer));
+                v(DESCRIBE_FIELD(ThingInfo, capabilities));
+            }
+
             ThingInfo()
             {
                 clear();
@@ -775,22 +1379,13 @@ namespace Magellan
 
         static void to_json(nlohmann::json& j, const ThingInfo& p)
         {
-            j = nlohmann::json{
-                TOJSON_IMPL(id),
-                TOJSON_IMPL(type),
-                TOJSON_IMPL(manufacturer),
-                TOJSON_IMPL(capabilities)
-            };
+            fieldsToJson(j, p);
         }
 
         static void from_json(const nlohmann::json& j, ThingInfo& p)
         {
-            p.clear();
-            FROMJSON_IMPL(id, std::string, EMPTY_STRING);
-            FROMJSON_IMPL(type, std::string, EMPTY_STRING);
-            FROMJSON_IMPL(manufacturer, std::string, EMPTY_STRING);
-            getOptional<std::vector<std::string>>("capabilities", p.capabilities, j);
-        }    
+            fieldsFromJson(j, p);
+        }
 
 
         //-----------------------------------------------------------
@@ -823,6 +1418,15 @@ namespace Magellan
              */
             int                                     intervalSecs;
 
+            /** @brief Serialized members - these drive serialization, deserialization and comparison */
+            template<class V>
+            static void describe(V& v)
+            {
+                v(DESCRIBE_FIELD(Presence, forceOnAudioTransmit));
+                v(DESCRIBE_FIELD(Presence, format));
+                v(DESCRIBE_FIELD(Presence, intervalSecs));
+            }
+
             Presence()
             {
                 clear();
@@ -837,28 +1441,19 @@ namespace Magellan
 
             virtual bool matches(Presence& other)
             {
-                return (forceOnAudioTransmit == other.forceOnAudioTransmit &&
-                        format == other.format &&
-                        intervalSecs == other.intervalSecs);
+                return fieldsMatch(*this, other);
             }
         };
 
         static void to_json(nlohmann::json& j, const Presence& p)
         {
-            j = nlohmann::json{
-                TOJSON_IMPL(forceOnAudioTransmit),
-                TOJSON_IMPL(format),
-                TOJSON_IMPL(intervalSecs)
-            };
+            fieldsToJson(j, p);
         }
 
         static void from_json(const nlohmann::json& j, Presence& p)
         {
-            p.clear();
-            FROMJSON_IMPL(forceOnAudioTransmit, bool, false);
-            FROMJSON_IMPL(format, int, 1);
-            FROMJSON_IMPL(intervalSecs, int, 30);
-        }    
+            fieldsFromJson(j, p);
+        }
 
 
         //-----------------------------------------------------------
@@ -917,6 +1512,20 @@ namespace Magellan
             int                                     trailingHeaderBurst;
 
 
+            /** @brief Serialized members - these drive serialization, deserialization and comparison */
+            template<class V>
+            static void describe(V& v)
+            {
+                v(DESCRIBE_FIELD(TxAudio, encoder));
+                v(DESCRIBE_FIELD(TxAudio, fdx));
+                v(DESCRIBE_FIELD(TxAudio, maxTxSecs));
+                v(DESCRIBE_FIELD(TxAudio, framingMs));
+                v(DESCRIBE_FIELD(TxAudio, noHdrExt));
+                v(DESCRIBE_FIELD(TxAudio, extensionSendInterval));
+                v(DESCRIBE_FIELD(TxAudio, initialHeaderBurst));
+                v(DESCRIBE_FIELD(TxAudio, trailingHeaderBurst));
+            }
+
             TxAudio()
             {
                 clear();
@@ -936,44 +1545,19 @@ namespace Magellan
 
             virtual bool matches(TxAudio& other)
             {
-                return ( encoder.compare(other.encoder) == 0 &&
-                        fdx == other.fdx &&
-                        maxTxSecs == other.maxTxSecs &&
-                        framingMs == other.framingMs &&
-                        noHdrExt == other.noHdrExt &&
-                        extensionSendInterval == other.extensionSendInterval &&
-                        initialHeaderBurst == other.initialHeaderBurst &&
-                        trailingHeaderBurst == other.trailingHeaderBurst
-                    );
+                return fieldsMatch(*this, other);
             }
         };
 
         static void to_json(nlohmann::json& j, const TxAudio& p)
         {
-            j = nlohmann::json{
-                TOJSON_IMPL(encoder),
-                TOJSON_IMPL(fdx),
-                TOJSON_IMPL(maxTxSecs),
-                TOJSON_IMPL(framingMs),
-                TOJSON_IMPL(noHdrExt),
-                TOJSON_IMPL(extensionSendInterval),
-                TOJSON_IMPL(initialHeaderBurst),
-                TOJSON_IMPL(trailingHeaderBurst)
-            };
+            fieldsToJson(j, p);
         }
 
         static void from_json(const nlohmann::json& j, TxAudio& p)
         {
-            p.clear();
-            FROMJSON_IMPL(encoder, std::string, "ctOpus8000");
-            FROMJSON_IMPL(fdx, bool, false);
-            FROMJSON_IMPL(maxTxSecs, int, 30);
-            FROMJSON_IMPL(framingMs, int, 60);
-            FROMJSON_IMPL(noHdrExt, bool, false);
-            FROMJSON_IMPL(extensionSendInterval, int, 10);
-            FROMJSON_IMPL(initialHeaderBurst, int, 5);
-            FROMJSON_IMPL(trailingHeaderBurst, int, 5);
-        }    
+            fieldsFromJson(j, p);
+        }
 
 
         //-----------------------------------------------------------
@@ -1002,6 +1586,14 @@ namespace Magellan
             int                                     ttl;
 
 
+            /** @brief Serialized members - these drive serialization, deserialization and comparison */
+            template<class V>
+            static void describe(V& v)
+            {
+                v(DESCRIBE_FIELD(NetworkOptions, priority));
+                v(DESCRIBE_FIELD(NetworkOptions, ttl));
+            }
+
             NetworkOptions()
             {
                 clear();
@@ -1015,26 +1607,19 @@ namespace Magellan
 
             virtual bool matches(NetworkOptions& other)
             {
-                return ( priority == other.priority &&
-                        ttl == other.ttl
-                    );
+                return fieldsMatch(*this, other);
             }
         };
 
         static void to_json(nlohmann::json& j, const NetworkOptions& p)
         {
-            j = nlohmann::json{
-                TOJSON_IMPL(priority),
-                TOJSON_IMPL(ttl)
-            };
+            fieldsToJson(j, p);
         }
 
         static void from_json(const nlohmann::json& j, NetworkOptions& p)
         {
-            p.clear();
-            FROMJSON_IMPL(priority, int, 4);
-            FROMJSON_IMPL(ttl, int, 1);
-        }    
+            fieldsFromJson(j, p);
+        }
 
 
         //-----------------------------------------------------------
@@ -1063,6 +1648,14 @@ namespace Magellan
             int                                     maxLevel;
 
 
+            /** @brief Serialized members - these drive serialization, deserialization and comparison */
+            template<class V>
+            static void describe(V& v)
+            {
+                v(DESCRIBE_FIELD(TalkgroupSecurity, minLevel));
+                v(DESCRIBE_FIELD(TalkgroupSecurity, maxLevel));
+            }
+
             TalkgroupSecurity()
             {
                 clear();
@@ -1076,25 +1669,18 @@ namespace Magellan
 
             virtual bool matches(TalkgroupSecurity& other)
             {
-                return ( minLevel == other.minLevel &&
-                        maxLevel == other.maxLevel
-                    );
+                return fieldsMatch(*this, other);
             }
         };
 
         static void to_json(nlohmann::json& j, const TalkgroupSecurity& p)
         {
-            j = nlohmann::json{
-                TOJSON_IMPL(minLevel),
-                TOJSON_IMPL(maxLevel)
-            };
+            fieldsToJson(j, p);
         }
 
         static void from_json(const nlohmann::json& j, TalkgroupSecurity& p)
         {
-            p.clear();
-            FROMJSON_IMPL(minLevel, int, 0);
-            FROMJSON_IMPL(maxLevel, int, 0);
+            fieldsFromJson(j, p);
         }
 
 
@@ -1118,6 +1704,13 @@ namespace Magellan
              */
             NetworkAddress                          host;
 
+            /** @brief Serialized members - these drive serialization, deserialization and comparison */
+            template<class V>
+            static void describe(V& v)
+            {
+                v(DESCRIBE_FIELD(Rallypoint, host));
+            }
+
             Rallypoint()
             {
                 clear();
@@ -1130,22 +1723,19 @@ namespace Magellan
 
             virtual bool matches(Rallypoint& other)
             {
-                return ( host.matches(other.host) );
+                return fieldsMatch(*this, other);
             }
         };
 
         static void to_json(nlohmann::json& j, const Rallypoint& p)
         {
-            j = nlohmann::json{
-                TOJSON_IMPL(host)
-            };
+            fieldsToJson(j, p);
         }
 
         static void from_json(const nlohmann::json& j, Rallypoint& p)
         {
-            p.clear();
-            getOptional<NetworkAddress>("host", p.host, j);
-        }    
+            fieldsFromJson(j, p);
+        }
 
 
         //-----------------------------------------------------------
@@ -1224,11 +1814,40 @@ namespace Magellan
              */
             TalkgroupSecurity                       security;
 
+            /**
+             * @brief Compact JSON of the talkgroup captured by cacheJson() - not itself serialized
+             */
+            std::shared_ptr<const std::string>      cachedJson;
+
+            /** @brief Serialized members - these drive serialization, deserialization and comparison */
+            template<class V>
+            static void describe(V& v)
+            {
+                v(DESCRIBE_FIELD(Talkgroup, deviceKey));
+                v(DESCRIBE_FIELD(Talkgroup, id));
+                v(DESCRIBE_FIELD(Talkgroup, type));
+                v(DESCRIBE_FIELD(Talkgroup, name));
+                v(DESCRIBE_FIELD(Talkgroup, cryptoPassword));
+                v(DESCRIBE_FIELD(Talkgroup, presence));
+                v(DESCRIBE_FIELD(Talkgroup, rallypoints));
+                v(DESCRIBE_FIELD(Talkgroup, rx));
+                v(DESCRIBE_FIELD(Talkgroup, tx));
+                v(DESCRIBE_FIELD(Talkgroup, txAudio));
+                v(DESCRIBE_FIELD(Talkgroup, networkOptions));
+                v(DESCRIBE_FIELD(Talkgroup, security));
+            }
+
             Talkgroup()
             {
                 clear();
             }
 
+            /** @brief Captures the compact serialization - only call once the talkgroup will no longer change */
+            void cacheJson();
+
+            /** @brief Appends the compact serialization, using the cached copy if there is one */
+            void appendJson(std::string& out) const;
+
             virtual void clear()
             {
                 deviceKey.clear();
@@ -1243,76 +1862,44 @@ namespace Magellan
                 txAudio.clear();
                 networkOptions.clear();
                 security.clear();
+                cachedJson.reset();
             }
 
             virtual bool matches(Talkgroup& other)
             {
-                if( deviceKey.compare(other.deviceKey) == 0 &&
-                    id.compare(other.id) == 0 &&
-                    type == other.type &&
-                    name.compare(other.name) == 0 &&
-                    cryptoPassword.compare(other.cryptoPassword) == 0 &&
-                    presence.matches(other.presence) &&
-                    rx.matches(other.rx) &&
-                    tx.matches(other.tx) &&
-                    txAudio.matches(other.txAudio) &&
-                    networkOptions.matches(other.networkOptions) &&
-                    security.matches(other.security)                
-                )
-                {
-                    // Looks good so far, now check out the rallypoint array
-                    if(rallypoints.size() == other.rallypoints.size())
-                    {
-                        for(size_t x = 0; x < rallypoints.size(); x++)
-                        {
-                            if(!rallypoints[x].matches(other.rallypoints[x]))
-                            {
-                                return false;
-                            }
-                        }
-
-                        return true;
-                    }
-                }
-
-                return false;
+                return fieldsMatch(*this, other);
             }
         };
 
         static void to_json(nlohmann::json& j, const Talkgroup& p)
         {
-            j = nlohmann::json{
-                TOJSON_IMPL(deviceKey),
-                TOJSON_IMPL(id),
-                TOJSON_IMPL(type),
-                TOJSON_IMPL(name),
-                TOJSON_IMPL(cryptoPassword),
-                TOJSON_IMPL(presence),
-                TOJSON_IMPL(rallypoints),
-                TOJSON_IMPL(rx),
-                TOJSON_IMPL(tx),
-                TOJSON_IMPL(txAudio),
-                TOJSON_IMPL(networkOptions),
-                TOJSON_IMPL(security)
-            };
+            fieldsToJson(j, p);
         }
 
         static void from_json(const nlohmann::json& j, Talkgroup& p)
         {
-            p.clear();
-            FROMJSON_IMPL(deviceKey, std::string, EMPTY_STRING);
-            FROMJSON_IMPL(id, std::string, EMPTY_STRING);
-            FROMJSON_IMPL(name, std::string, EMPTY_STRING);
-            FROMJSON_IMPL(type, int, 0);
-            FROMJSON_IMPL(cryptoPassword, std::string, EMPTY_STRING);
-            getOptional<Presence>("presence", p.presence, j);
-            getOptional<std::vector<Rallypoint>>("rallypoints", p.rallypoints, j);
-            getOptional<NetworkAddress>("rx", p.rx, j);
-            getOptional<NetworkAddress>("tx", p.tx, j);
-            getOptional<TxAudio>("txAudio", p.txAudio, j);
-            getOptional<NetworkOptions>("networkOptions", p.networkOptions, j);
-            getOptional<TalkgroupSecurity>("security", p.security, j);
-        }    
+            fieldsFromJson(j, p);
+        }
+
+        inline void Talkgroup::cacheJson()
+        {
+            cachedJson.reset();
+            nlohmann::json j = *this;
+            cachedJson = std::make_shared<const std::string>(j.dump());
+        }
+
+        inline void Talkgroup::appendJson(std::string& out) const
+        {
+            if(cachedJson)
+            {
+                out.append(*cachedJson);
+            }
+            else
+            {
+                nlohmann::json j = *this;
+                out.append(j.dump());
+            }
+        }
 
 
         //-----------------------------------------------------------
@@ -1355,6 +1942,17 @@ namespace Magellan
              */
             std::vector<Talkgroup>                  talkgroups;
 
+            /** @brief Serialized members - these drive serialization, deserialization and comparison */
+            template<class V>
+            static void describe(V& v)
+            {
+                v(DESCRIBE_FIELD(DeviceConfiguration, discovererKey));
+                v(DESCRIBE_FIELD(DeviceConfiguration, version));
+                v(DESCRIBE_FIELD(DeviceConfiguration, dateTimeStamp));
+                v(DESCRIBE_FIELD(DeviceConfiguration, thingInfo));
+                v(DESCRIBE_FIELD(DeviceConfiguration, talkgroups));
+            }
+
             DeviceConfiguration()
             {
                 clear();
@@ -1371,25 +1969,177 @@ namespace Magellan
         };
 
         static void to_json(nlohmann::json& j, const DeviceConfiguration& p)
+        {
+            fieldsToJson(j, p);
+        }
+
+        static void from_json(const nlohmann::json& j, DeviceConfiguration& p)
+        {
+            fieldsFromJson(j, p);
+        }
+
+        //-----------------------------------------------------------
+        JSON_SERIALIZED_CLASS(TalkgroupSubscription)
+        /**
+        * @brief Helper class for serializing and deserializing the TalkgroupSubscription JSON
+        *
+        * Predicate for a talkgroup event subscriber.  Empty/negative members match everything and
+        * the populated members are combined (AND).
+        *
+        * Example: @include[doc] examples/TalkgroupSubscription.json
+        */
+        class TalkgroupSubscription : public JsonObjectBase
+        {
+            IMPLEMENT_JSON_SERIALIZATION()
+            IMPLEMENT_JSON_DOCUMENTATION(TalkgroupSubscription)
+
+        public:
+            /**
+             * @brief Only talkgroups of these types
+             */
+            std::vector<int>                        types;
+
+            /**
+             * @brief Only talkgroups hosted by this device
+             */
+            std::string                             deviceKey;
+
+            /**
+             * @brief Only talkgroups whose name starts with this
+             */
+            std::string                             namePrefix;
+
+            /**
+             * @brief Only talkgroups accessible at this security level (security.minLevel <= securityLevel), -1 for any
+             */
+            int                                     securityLevel;
+
+            TalkgroupSubscription()
+            {
+                clear();
+            }
+
+            virtual void clear()
+            {
+                types.clear();
+                deviceKey.clear();
+                namePrefix.clear();
+                securityLevel = -1;
+            }
+
+            bool wants(const Talkgroup& tg) const
+            {
+                if(!types.empty() && std::find(types.begin(), types.end(), tg.type) == types.end())
+                {
+                    return false;
+                }
+
+                if(!deviceKey.empty() && tg.deviceKey.compare(deviceKey) != 0)
+                {
+                    return false;
+                }
+
+                if(!namePrefix.empty() && tg.name.compare(0, namePrefix.size(), namePrefix) != 0)
+                {
+                    return false;
+                }
+
+                if(securityLevel >= 0 && tg.security.minLevel > securityLevel)
+                {
+                    return false;
+                }
+
+                return true;
+            }
+        };
+
+        static void to_json(nlohmann::json& j, const TalkgroupSubscription& p)
         {
             j = nlohmann::json{
-                TOJSON_IMPL(discovererKey),
-                TOJSON_IMPL(version),
-                TOJSON_IMPL(dateTimeStamp),
-                TOJSON_IMPL(thingInfo),
-                TOJSON_IMPL(talkgroups)
+                TOJSON_IMPL(types),
+                TOJSON_IMPL(deviceKey),
+                TOJSON_IMPL(namePrefix),
+                TOJSON_IMPL(securityLevel)
             };
         }
 
-        static void from_json(const nlohmann::json& j, DeviceConfiguration& p)
+        static void from_json(const nlohmann::json& j, TalkgroupSubscription& p)
         {
             p.clear();
-            FROMJSON_IMPL(discovererKey, std::string, EMPTY_STRING);
-            FROMJSON_IMPL(version, unsigned long, 0);
-            FROMJSON_IMPL(dateTimeStamp, std::string, EMPTY_STRING);
-            getOptional<ThingInfo>("thingInfo", p.thingInfo, j);
-            getOptional<std::vector<Talkgroup>>("talkgroups", p.talkgroups, j);
-        } 
+            getOptional<std::vector<int>>("types", p.types, j);
+            FROMJSON_IMPL(deviceKey, std::string, EMPTY_STRING);
+            FROMJSON_IMPL(namePrefix, std::string, EMPTY_STRING);
+            FROMJSON_IMPL(securityLevel, int, -1);
+        }
+
+        //-----------------------------------------------------------
+        JSON_SERIALIZED_CLASS(TalkgroupQuery)
+        /**
+        * @brief Helper class for serializing and deserializing the TalkgroupQuery JSON
+        *
+        * Filter used when querying the talkgroup registry.  Empty/negative members match everything and
+        * the populated members are combined (AND).
+        *
+        * Example: @include[doc] examples/TalkgroupQuery.json
+        */
+        class TalkgroupQuery : public JsonObjectBase
+        {
+            IMPLEMENT_JSON_SERIALIZATION()
+            IMPLEMENT_JSON_DOCUMENTATION(TalkgroupQuery)
+
+        public:
+            /**
+             * @brief Only talkgroups hosted by this device
+             */
+            std::string                             deviceKey;
+
+            /**
+             * @brief Only talkgroups of this type (-1 for any)
+             */
+            int                                     type;
+
+            /**
+             * @brief Only talkgroups using this multicast address for rx or tx
+             */
+            std::string                             address;
+
+            /**
+             * @brief Only talkgroups accessible at this security level (security.minLevel <= securityLevel), -1 for any
+             */
+            int                                     securityLevel;
+
+            TalkgroupQuery()
+            {
+                clear();
+            }
+
+            virtual void clear()
+            {
+                deviceKey.clear();
+                type = -1;
+                address.clear();
+                securityLevel = -1;
+            }
+        };
+
+        static void to_json(nlohmann::json& j, const TalkgroupQuery& p)
+        {
+            j = nlohmann::json{
+                TOJSON_IMPL(deviceKey),
+                TOJSON_IMPL(type),
+                TOJSON_IMPL(address),
+                TOJSON_IMPL(securityLevel)
+            };
+        }
+
+        static void from_json(const nlohmann::json& j, TalkgroupQuery& p)
+        {
+            p.clear();
+            FROMJSON_IMPL(deviceKey, std::string, EMPTY_STRING);
+            FROMJSON_IMPL(type, int, -1);
+            FROMJSON_IMPL(address, std::string, EMPTY_STRING);
+            FROMJSON_IMPL(securityLevel, int, -1);
+        }
     }
 }
 #endif
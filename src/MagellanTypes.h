@@ -6,6 +6,9 @@
 #ifndef MAGELLANTYPES_H
 #define MAGELLANTYPES_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #if defined(WIN32)
     #ifdef MAGELLAN_EXPORTS
         #define MAGELLAN_API  __declspec(dllexport) extern
@@ -39,4 +42,66 @@ typedef void (* _Nullable PFN_MAGELLAN_ON_MODIFIED_TALKGROUPS)(const char * _Non
 /** @brief Prototype for notification of removed talkgroups **/
 typedef void (* _Nullable PFN_MAGELLAN_ON_REMOVED_TALKGROUPS)(const char * _Nonnull removedTalkgroupsJson, const void * _Nullable userData);
 
+/** @brief A string held in a view arena - the characters are at arena + offset and are also null-terminated **/
+typedef struct _MagellanStringRef_t
+{
+    uint32_t    offset;
+    uint32_t    length;
+} MagellanStringRef_t;
+
+/** @brief Flat, read-only view of a Rallypoint **/
+typedef struct _MagellanRallypointView_t
+{
+    MagellanStringRef_t     hostAddress;
+    int                     hostPort;
+} MagellanRallypointView_t;
+
+/** @brief Flat, read-only view of a Talkgroup **/
+typedef struct _MagellanTalkgroupView_t
+{
+    MagellanStringRef_t     id;
+    MagellanStringRef_t     deviceKey;
+    MagellanStringRef_t     name;
+    MagellanStringRef_t     cryptoPassword;
+    int                     type;
+
+    MagellanStringRef_t     rxAddress;
+    int                     rxPort;
+    MagellanStringRef_t     txAddress;
+    int                     txPort;
+
+    MagellanStringRef_t     txEncoder;
+    int                     txFramingMs;
+    int                     txMaxTxSecs;
+    int                     txFdx;
+
+    int                     presenceFormat;
+    int                     presenceIntervalSecs;
+
+    /** @brief This talkgroup's rallypoints are rallypoints[firstRallypoint] to rallypoints[firstRallypoint + rallypointCount - 1] **/
+    uint32_t                firstRallypoint;
+    uint32_t                rallypointCount;
+
+    /** @brief For modifications, which parts changed (see talkgroupChangeMask) - 0 otherwise **/
+    uint32_t                changeMask;
+} MagellanTalkgroupView_t;
+
+/** 
+ * @brief A set of talkgroup views delivered to a view callback
+ * 
+ * All strings live in a single arena.  The set, and everything it points to, is only valid for the duration of the callback.
+ **/
+typedef struct _MagellanTalkgroupViewSet_t
+{
+    const MagellanTalkgroupView_t * _Nullable   talkgroups;
+    size_t                                      talkgroupCount;
+    const MagellanRallypointView_t * _Nullable  rallypoints;
+    size_t                                      rallypointCount;
+    const char * _Nullable                      arena;
+    size_t                                      arenaSize;
+} MagellanTalkgroupViewSet_t;
+
+/** @brief Prototype for view-based talkgroup notifications (new/modified carry full views, removed carry only the ids) **/
+typedef void (* _Nullable PFN_MAGELLAN_ON_TALKGROUP_VIEWS)(const MagellanTalkgroupViewSet_t * _Nonnull viewSet, const void * _Nullable userData);
+
 #endif
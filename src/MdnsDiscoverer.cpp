@@ -0,0 +1,900 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#if defined(WIN32)
+    #include <WinSock2.h>
+	#include <Ws2tcpip.h>
+	#include <mswsock.h>
+
+    #define ssize_t SSIZE_T
+#else
+    #include <unistd.h>
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+    #include <sys/time.h>
+
+    #define closesocket close
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "MdnsDiscoverer.hpp"
+#include "ILogger.hpp"
+#include "MagellanCore.hpp"
+#include "MagellanDataModel.hpp"
+
+namespace Magellan
+{
+    static const char *TAG = "MdnsDiscoverer";
+
+    static const char *MDNS_GROUP_V4 = "224.0.0.251";
+    static const char *MDNS_GROUP_V6 = "ff02::fb";
+    static const int MDNS_PORT = 5353;
+
+    // RFC 6762 recommends staying comfortably under the Ethernet MTU
+    static const size_t MAX_QUERY_SIZE = 1400;
+
+    // Minimum time between targeted (SRV/TXT/A/AAAA) queries for the same name
+    static const uint64_t MIN_REQUERY_MS = 1000;
+
+    // RFC 6762 10.1/10.2 - goodbyes and flushed records linger for one second
+    static const uint64_t GOODBYE_LINGER_MS = 1000;
+
+    // Large enough for a jumbo-frame response
+    static const size_t BUFF_SZ = 9000;
+
+    MdnsDiscoverer::MdnsDiscoverer()
+    {
+        #if defined(WIN32)
+            WSADATA wsa;
+            WSAStartup(MAKEWORD(2, 2), &wsa);
+        #endif
+
+        setImplementation("Mdns-Native");
+        _running = false;
+        _sock4 = -1;
+        _sock6 = -1;
+        _nextQueryAt = 0;
+        _queryIntervalMs = 0;
+    }
+
+    MdnsDiscoverer::~MdnsDiscoverer()
+    {
+        #if defined(WIN32)
+            WSACleanup();
+        #endif
+    }
+
+    void MdnsDiscoverer::deleteThis()
+    {
+        stop();
+        ReferenceCountedObject::deleteThis();
+    }
+
+    bool MdnsDiscoverer::configure(DataModel::JsonObjectBase& configuration)
+    {
+        _configuration = (DataModel::Mdns&)configuration;
+        _serviceName = _configuration.serviceType;
+        _serviceName.append(".local");
+        return true;
+    }
+
+    bool MdnsDiscoverer::start()
+    {
+        Core::getLogger()->d(TAG, "{%p} started for '%s'", (void*) this, _serviceName.c_str());
+
+        if(_running)
+        {
+            return true;
+        }
+
+        _running = true;
+
+        _workerThreadHandle = std::thread(&MdnsDiscoverer::workerThread, this);
+
+        return true;
+    }
+
+    void MdnsDiscoverer::stop()
+    {
+        Core::getLogger()->d(TAG, "{%p} stopped", (void*) this);
+
+        _running = false;
+
+        if(_workerThreadHandle.joinable())
+        {
+            _workerThreadHandle.join();
+        }
+    }
+
+    void MdnsDiscoverer::pause()
+    {
+        Core::getLogger()->d(TAG, "{%p} paused", (void*) this);
+    }
+
+    void MdnsDiscoverer::resume()
+    {
+        Core::getLogger()->d(TAG, "{%p} resumed", (void*) this);
+    }
+
+    bool MdnsDiscoverer::openSockets()
+    {
+        closeSockets();
+
+        // IPv4 is mandatory
+        {
+            _sock4 = (int)socket(AF_INET, SOCK_DGRAM, 0);
+            if(_sock4 < 0)
+            {
+                Core::getLogger()->e(TAG, "socket(AF_INET) failed");
+                return false;
+            }
+
+            int reuse = 1;
+            setsockopt(_sock4, SOL_SOCKET, SO_REUSEADDR, (char*)&reuse, sizeof(reuse));
+            #if defined(SO_REUSEPORT)
+                // Lets us coexist with another responder/querier on the same host
+                setsockopt(_sock4, SOL_SOCKET, SO_REUSEPORT, (char*)&reuse, sizeof(reuse));
+            #endif
+
+            struct sockaddr_in local;
+            memset(&local, 0, sizeof(local));
+            local.sin_family = AF_INET;
+            local.sin_port = htons(MDNS_PORT);
+            local.sin_addr.s_addr = INADDR_ANY;
+            if(bind(_sock4, (struct sockaddr*)&local, sizeof(local)) != 0)
+            {
+                Core::getLogger()->e(TAG, "bind(%d) failed", MDNS_PORT);
+                closeSockets();
+                return false;
+            }
+
+            struct ip_mreq group;
+            memset(&group, 0, sizeof(group));
+            inet_pton(AF_INET, MDNS_GROUP_V4, &group.imr_multiaddr);
+            if(setsockopt(_sock4, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)&group, sizeof(group)) != 0)
+            {
+                Core::getLogger()->e(TAG, "setsockopt(IP_ADD_MEMBERSHIP) failed");
+                closeSockets();
+                return false;
+            }
+
+            unsigned char ttl = 255;
+            setsockopt(_sock4, IPPROTO_IP, IP_MULTICAST_TTL, (char*)&ttl, sizeof(ttl));
+
+            unsigned char loop = (_configuration.enableLoopback ? 1 : 0);
+            setsockopt(_sock4, IPPROTO_IP, IP_MULTICAST_LOOP, (char*)&loop, sizeof(loop));
+        }
+
+        // IPv6 is best-effort - plenty of embedded targets and containers have it disabled
+        if(_configuration.enableIpv6)
+        {
+            _sock6 = (int)socket(AF_INET6, SOCK_DGRAM, 0);
+            if(_sock6 >= 0)
+            {
+                int on = 1;
+                setsockopt(_sock6, SOL_SOCKET, SO_REUSEADDR, (char*)&on, sizeof(on));
+                #if defined(SO_REUSEPORT)
+                    setsockopt(_sock6, SOL_SOCKET, SO_REUSEPORT, (char*)&on, sizeof(on));
+                #endif
+                setsockopt(_sock6, IPPROTO_IPV6, IPV6_V6ONLY, (char*)&on, sizeof(on));
+
+                struct sockaddr_in6 local;
+                memset(&local, 0, sizeof(local));
+                local.sin6_family = AF_INET6;
+                local.sin6_port = htons(MDNS_PORT);
+                local.sin6_addr = in6addr_any;
+
+                struct ipv6_mreq group;
+                memset(&group, 0, sizeof(group));
+                inet_pton(AF_INET6, MDNS_GROUP_V6, &group.ipv6mr_multiaddr);
+                group.ipv6mr_interface = 0;
+
+                int hops = 255;
+                unsigned int loop = (_configuration.enableLoopback ? 1 : 0);
+
+                if(bind(_sock6, (struct sockaddr*)&local, sizeof(local)) != 0 ||
+                   setsockopt(_sock6, IPPROTO_IPV6, IPV6_JOIN_GROUP, (char*)&group, sizeof(group)) != 0)
+                {
+                    Core::getLogger()->w(TAG, "IPv6 mDNS unavailable - continuing with IPv4 only");
+                    closesocket(_sock6);
+                    _sock6 = -1;
+                }
+                else
+                {
+                    setsockopt(_sock6, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, (char*)&hops, sizeof(hops));
+                    setsockopt(_sock6, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, (char*)&loop, sizeof(loop));
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void MdnsDiscoverer::closeSockets()
+    {
+        if(_sock4 >= 0)
+        {
+            closesocket(_sock4);
+            _sock4 = -1;
+        }
+
+        if(_sock6 >= 0)
+        {
+            closesocket(_sock6);
+            _sock6 = -1;
+        }
+    }
+
+    void MdnsDiscoverer::workerThread()
+    {
+        uint8_t     buffer[BUFF_SZ];
+        uint64_t    errCount = 0;
+
+        _cache.clear();
+        _reported.clear();
+        _filtered.clear();
+        _lastQueried.clear();
+
+        while( _running )
+        {
+            if(errCount > 0)
+            {
+                uint64_t msWait = (errCount * 1000);
+                if(msWait > _configuration.maxQueryIntervalMs)
+                {
+                    msWait = _configuration.maxQueryIntervalMs;
+                }
+
+                Core::getLogger()->d(TAG, "waiting for %" PRIu64 " milliseconds before reopening sockets", msWait);
+
+                uint64_t tsStarted = Core::getNowMs();
+                while(_running && (Core::getNowMs() - tsStarted) < msWait)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+
+                if(!_running)
+                {
+                    break;
+                }
+            }
+
+            if(!openSockets())
+            {
+                errCount++;
+                continue;
+            }
+
+            // Continuous querying restarts at the initial interval whenever the sockets are (re)opened
+            _queryIntervalMs = _configuration.queryIntervalMs;
+            _nextQueryAt = 0;
+
+            while( _running )
+            {
+                uint64_t now = Core::getNowMs();
+
+                expireCache(now);
+                evaluateInstances(now);
+
+                if(now >= _nextQueryAt)
+                {
+                    sendServiceQuery(now);
+                }
+                else
+                {
+                    refreshCache(now);
+                }
+
+                int             nfds;
+                fd_set          readfds;
+                struct timeval  tv;
+                int             result;
+
+                FD_ZERO(&readfds);
+                FD_SET(_sock4, &readfds);
+                nfds = _sock4;
+
+                if(_sock6 >= 0)
+                {
+                    FD_SET(_sock6, &readfds);
+                    if(_sock6 > nfds)
+                    {
+                        nfds = _sock6;
+                    }
+                }
+
+                #if defined(WIN32)
+                    nfds = 0;
+                #else
+                    nfds++;
+                #endif
+
+                // Wake up at least every 250ms to service expiries, refreshes and the query schedule
+                tv.tv_sec = 0;
+                tv.tv_usec = 250 * 1000;
+
+                result = select(nfds, &readfds, (fd_set*)nullptr, (fd_set*)nullptr, &tv);
+                if(result < 0)
+                {
+                    Core::getLogger()->e(TAG, "select() failed, errno=%d", errno);
+                    errCount++;
+                    break;
+                }
+
+                if(result > 0)
+                {
+                    int socks[2] = {_sock4, _sock6};
+
+                    for(int x = 0; x < 2; x++)
+                    {
+                        if(socks[x] >= 0 && FD_ISSET(socks[x], &readfds))
+                        {
+                            ssize_t rc = recvfrom(socks[x], (char*)buffer, BUFF_SZ, 0, nullptr, nullptr);
+                            if(rc > 0)
+                            {
+                                errCount = 0;
+                                processPacket(buffer, (size_t)rc, Core::getNowMs());
+                            }
+                        }
+                    }
+                }
+            }
+
+            closeSockets();
+        }
+
+        closeSockets();
+
+        for(ReportedMap_t::iterator itr = _reported.begin();
+            itr != _reported.end();
+            itr++)
+        {
+            Core::processUndiscoveredDevice(itr->first.c_str());
+        }
+
+        _reported.clear();
+        _cache.clear();
+    }
+
+    void MdnsDiscoverer::sendMessage(const DnsMessage& msg)
+    {
+        std::vector<uint8_t> wire;
+        msg.encode(wire);
+
+        if(_sock4 >= 0)
+        {
+            struct sockaddr_in dst;
+            memset(&dst, 0, sizeof(dst));
+            dst.sin_family = AF_INET;
+            dst.sin_port = htons(MDNS_PORT);
+            inet_pton(AF_INET, MDNS_GROUP_V4, &dst.sin_addr);
+
+            if(sendto(_sock4, (const char*)wire.data(), (int)wire.size(), 0, (struct sockaddr*)&dst, sizeof(dst)) != (ssize_t)wire.size())
+            {
+                Core::getLogger()->e(TAG, "sendto() failed on IPv4, errno=%d", errno);
+            }
+        }
+
+        if(_sock6 >= 0)
+        {
+            struct sockaddr_in6 dst;
+            memset(&dst, 0, sizeof(dst));
+            dst.sin6_family = AF_INET6;
+            dst.sin6_port = htons(MDNS_PORT);
+            inet_pton(AF_INET6, MDNS_GROUP_V6, &dst.sin6_addr);
+
+            if(sendto(_sock6, (const char*)wire.data(), (int)wire.size(), 0, (struct sockaddr*)&dst, sizeof(dst)) != (ssize_t)wire.size())
+            {
+                Core::getLogger()->w(TAG, "sendto() failed on IPv6, errno=%d", errno);
+            }
+        }
+    }
+
+    void MdnsDiscoverer::sendServiceQuery(uint64_t now)
+    {
+        DnsMessage msg;
+
+        DnsMessage::Question q;
+        q.name = _serviceName;
+        q.type = DnsMessage::TYPE_PTR;
+        msg.questions.push_back(q);
+
+        // Known-answer suppression (RFC 6762 7.1) - list PTRs that still have more than half their TTL left
+        size_t approxSize = 12 + _serviceName.size() + 6;
+
+        for(RecordCache_t::iterator itr = _cache.begin();
+            itr != _cache.end();
+            itr++)
+        {
+            const DnsMessage::Record& rr = itr->second._rr;
+
+            if(rr.type != DnsMessage::TYPE_PTR || !DnsMessage::namesEqual(rr.name, _serviceName))
+            {
+                continue;
+            }
+
+            uint64_t remaining = (itr->second._expiresAt > now ? (itr->second._expiresAt - now) : 0);
+            if(remaining * 2 <= (uint64_t)rr.ttl * 1000)
+            {
+                continue;
+            }
+
+            // The remaining answers will simply be re-announced to us; no truncated multi-packet queries
+            size_t recSize = rr.name.size() + rr.target.size() + 14;
+            if(approxSize + recSize > MAX_QUERY_SIZE)
+            {
+                break;
+            }
+
+            DnsMessage::Record ka = rr;
+            ka.cacheFlush = false;
+            ka.ttl = (uint32_t)(remaining / 1000);
+            msg.answers.push_back(ka);
+            approxSize += recSize;
+        }
+
+        sendMessage(msg);
+
+        _lastQueried[DnsMessage::nameKey(_serviceName)] = now;
+
+        // RFC 6762 5.2 - the interval between continuous queries at least doubles each time
+        _nextQueryAt = now + _queryIntervalMs;
+        _queryIntervalMs *= 2;
+        if(_queryIntervalMs > _configuration.maxQueryIntervalMs)
+        {
+            _queryIntervalMs = _configuration.maxQueryIntervalMs;
+        }
+    }
+
+    void MdnsDiscoverer::sendQuestions(const std::set<std::pair<std::string, uint16_t>>& questions, uint64_t now)
+    {
+        if(questions.empty())
+        {
+            return;
+        }
+
+        DnsMessage msg;
+
+        for(std::set<std::pair<std::string, uint16_t>>::const_iterator itr = questions.begin();
+            itr != questions.end();
+            itr++)
+        {
+            DnsMessage::Question q;
+            q.name = itr->first;
+            q.type = itr->second;
+            msg.questions.push_back(q);
+
+            _lastQueried[DnsMessage::nameKey(itr->first)] = now;
+        }
+
+        sendMessage(msg);
+    }
+
+    std::string MdnsDiscoverer::cacheKey(const DnsMessage::Record& rr)
+    {
+        std::string key = DnsMessage::nameKey(rr.name);
+        char tmp[16];
+
+        snprintf(tmp, sizeof(tmp), "/%u/", (unsigned)rr.type);
+        key.append(tmp);
+
+        switch(rr.type)
+        {
+            case DnsMessage::TYPE_PTR:
+                key.append(DnsMessage::nameKey(rr.target));
+                break;
+
+            case DnsMessage::TYPE_SRV:
+                snprintf(tmp, sizeof(tmp), "%u/", (unsigned)rr.port);
+                key.append(tmp);
+                key.append(DnsMessage::nameKey(rr.target));
+                break;
+
+            default:
+                key.append((const char*)rr.rdata.data(), rr.rdata.size());
+                break;
+        }
+
+        return key;
+    }
+
+    void MdnsDiscoverer::cacheRecord(const DnsMessage::Record& rr, uint64_t now)
+    {
+        std::string key = cacheKey(rr);
+        RecordCache_t::iterator itr = _cache.find(key);
+
+        // Goodbye (RFC 6762 10.1) - keep the record for one more second then let it go
+        if(rr.ttl == 0)
+        {
+            if(itr != _cache.end())
+            {
+                itr->second._expiresAt = now + GOODBYE_LINGER_MS;
+                itr->second._refreshesSent = 4;
+            }
+
+            return;
+        }
+
+        // Cache-flush (RFC 6762 10.2) - anything of this name/type older than one second is stale
+        if(rr.cacheFlush)
+        {
+            for(RecordCache_t::iterator itrFlush = _cache.begin();
+                itrFlush != _cache.end();
+                itrFlush++)
+            {
+                if(itrFlush->first != key &&
+                   itrFlush->second._rr.type == rr.type &&
+                   itrFlush->second._receivedAt + GOODBYE_LINGER_MS < now &&
+                   DnsMessage::namesEqual(itrFlush->second._rr.name, rr.name) &&
+                   itrFlush->second._expiresAt > now + GOODBYE_LINGER_MS)
+                {
+                    itrFlush->second._expiresAt = now + GOODBYE_LINGER_MS;
+                }
+            }
+        }
+
+        CacheEntry_t ce;
+        ce._rr = rr;
+        ce._receivedAt = now;
+        ce._expiresAt = now + ((uint64_t)rr.ttl * 1000);
+        ce._refreshesSent = 0;
+
+        _cache[key] = ce;
+    }
+
+    void MdnsDiscoverer::processPacket(const uint8_t *data, size_t len, uint64_t now)
+    {
+        DnsMessage msg;
+
+        if(!msg.parse(data, len))
+        {
+            Core::getLogger()->d(TAG, "ignoring malformed mDNS packet of %zu bytes", len);
+            return;
+        }
+
+        // Queries (ours included, via loopback) carry nothing we want to cache
+        if((msg.flags & DnsMessage::FLAG_RESPONSE) == 0)
+        {
+            return;
+        }
+
+        const std::vector<DnsMessage::Record> *sections[2] = {&msg.answers, &msg.additionals};
+
+        for(int s = 0; s < 2; s++)
+        {
+            for(std::vector<DnsMessage::Record>::const_iterator itr = sections[s]->begin();
+                itr != sections[s]->end();
+                itr++)
+            {
+                switch(itr->type)
+                {
+                    case DnsMessage::TYPE_PTR:
+                    case DnsMessage::TYPE_SRV:
+                    case DnsMessage::TYPE_TXT:
+                    case DnsMessage::TYPE_A:
+                    case DnsMessage::TYPE_AAAA:
+                        if(itr->klass == DnsMessage::CLASS_IN)
+                        {
+                            cacheRecord(*itr, now);
+                        }
+                        break;
+
+                    default:
+                        break;
+                }
+            }
+        }
+
+        evaluateInstances(now);
+    }
+
+    void MdnsDiscoverer::expireCache(uint64_t now)
+    {
+        for(RecordCache_t::iterator itr = _cache.begin();
+            itr != _cache.end();)
+        {
+            if(itr->second._expiresAt <= now)
+            {
+                itr = _cache.erase(itr);
+            }
+            else
+            {
+                itr++;
+            }
+        }
+    }
+
+    void MdnsDiscoverer::refreshCache(uint64_t now)
+    {
+        // RFC 6762 5.2 - requery at 80%, 85%, 90% and 95% of a record's lifetime
+        std::set<std::pair<std::string, uint16_t>> questions;
+        bool serviceQueryNeeded = false;
+
+        for(RecordCache_t::iterator itr = _cache.begin();
+            itr != _cache.end();
+            itr++)
+        {
+            CacheEntry_t& ce = itr->second;
+
+            if(ce._refreshesSent >= 4)
+            {
+                continue;
+            }
+
+            uint64_t lifetime = ((uint64_t)ce._rr.ttl * 1000);
+            uint64_t due = ce._receivedAt + ((lifetime * (80 + (5 * ce._refreshesSent))) / 100);
+
+            if(now < due)
+            {
+                continue;
+            }
+
+            ce._refreshesSent++;
+
+            if(ce._rr.type == DnsMessage::TYPE_PTR && DnsMessage::namesEqual(ce._rr.name, _serviceName))
+            {
+                serviceQueryNeeded = true;
+            }
+            else
+            {
+                questions.insert(std::make_pair(ce._rr.name, ce._rr.type));
+            }
+        }
+
+        if(serviceQueryNeeded)
+        {
+            // Refreshing the PTRs is just an early continuous query - it carries known answers too
+            uint64_t savedInterval = _queryIntervalMs;
+            uint64_t savedNext = _nextQueryAt;
+            sendServiceQuery(now);
+            _queryIntervalMs = savedInterval;
+            _nextQueryAt = savedNext;
+        }
+
+        sendQuestions(questions, now);
+    }
+
+    const MdnsDiscoverer::CacheEntry_t *MdnsDiscoverer::findRecord(const std::string& name, uint16_t type)
+    {
+        const CacheEntry_t *rc = nullptr;
+
+        for(RecordCache_t::iterator itr = _cache.begin();
+            itr != _cache.end();
+            itr++)
+        {
+            if(itr->second._rr.type == type && DnsMessage::namesEqual(itr->second._rr.name, name))
+            {
+                // Prefer the freshest of several candidates
+                if(rc == nullptr || itr->second._receivedAt > rc->_receivedAt)
+                {
+                    rc = &itr->second;
+                }
+            }
+        }
+
+        return rc;
+    }
+
+    std::string MdnsDiscoverer::instanceLabel(const std::string& instanceName)
+    {
+        if(instanceName.size() > _serviceName.size() + 1)
+        {
+            return instanceName.substr(0, instanceName.size() - _serviceName.size() - 1);
+        }
+
+        return instanceName;
+    }
+
+    std::string MdnsDiscoverer::makeDiscovererKey(const std::string& instanceName)
+    {
+        std::string key;
+        key.assign(getImplementation());
+        key.append("/");
+        key.append(_configuration.serviceType);
+        key.append("/local/");
+        key.append(instanceLabel(instanceName));
+
+        return key;
+    }
+
+    void MdnsDiscoverer::evaluateInstances(uint64_t now)
+    {
+        std::set<std::string>                       present;
+        std::set<std::string>                       live;
+        std::set<std::pair<std::string, uint16_t>>  questions;
+
+        for(RecordCache_t::iterator itr = _cache.begin();
+            itr != _cache.end();
+            itr++)
+        {
+            const DnsMessage::Record& ptr = itr->second._rr;
+
+            if(ptr.type != DnsMessage::TYPE_PTR || !DnsMessage::namesEqual(ptr.name, _serviceName))
+            {
+                continue;
+            }
+
+            // A PTR in its goodbye second is already gone as far as we're concerned
+            if(itr->second._expiresAt <= now + GOODBYE_LINGER_MS && itr->second._refreshesSent >= 4)
+            {
+                continue;
+            }
+
+            const std::string& instance = ptr.target;
+            std::string key = makeDiscovererKey(instance);
+
+            present.insert(key);
+
+            // The application has already said it doesn't want this one
+            if(_filtered.find(key) != _filtered.end())
+            {
+                continue;
+            }
+
+            const CacheEntry_t *srv = findRecord(instance, DnsMessage::TYPE_SRV);
+            const CacheEntry_t *txt = findRecord(instance, DnsMessage::TYPE_TXT);
+            const CacheEntry_t *a = nullptr;
+            const CacheEntry_t *aaaa = nullptr;
+
+            if(srv != nullptr)
+            {
+                a = findRecord(srv->_rr.target, DnsMessage::TYPE_A);
+                aaaa = findRecord(srv->_rr.target, DnsMessage::TYPE_AAAA);
+            }
+
+            // Responders normally send everything as additionals, but chase whatever is missing
+            bool canQuery = (now - _lastQueried[DnsMessage::nameKey(instance)] >= MIN_REQUERY_MS);
+
+            if(srv == nullptr && canQuery)
+            {
+                questions.insert(std::make_pair(instance, DnsMessage::TYPE_SRV));
+            }
+
+            if(txt == nullptr && canQuery)
+            {
+                questions.insert(std::make_pair(instance, DnsMessage::TYPE_TXT));
+            }
+
+            if(srv != nullptr && a == nullptr && aaaa == nullptr &&
+               (now - _lastQueried[DnsMessage::nameKey(srv->_rr.target)] >= MIN_REQUERY_MS))
+            {
+                questions.insert(std::make_pair(srv->_rr.target, DnsMessage::TYPE_A));
+                if(_sock6 >= 0)
+                {
+                    questions.insert(std::make_pair(srv->_rr.target, DnsMessage::TYPE_AAAA));
+                }
+            }
+
+            if(srv == nullptr || txt == nullptr || (a == nullptr && aaaa == nullptr))
+            {
+                // Still resolving - if we had previously reported it, keep it alive until the PTR goes
+                if(_reported.find(key) != _reported.end())
+                {
+                    live.insert(key);
+                }
+
+                continue;
+            }
+
+            live.insert(key);
+
+            std::string     id;
+            unsigned long   version = 0;
+
+            for(std::vector<std::string>::const_iterator itrTxt = txt->_rr.txt.begin();
+                itrTxt != txt->_rr.txt.end();
+                itrTxt++)
+            {
+                if(itrTxt->compare(0, 3, "id=") == 0)
+                {
+                    id = itrTxt->substr(3);
+                }
+                else if(itrTxt->compare(0, 3, "cv=") == 0)
+                {
+                    version = (unsigned long)atol(itrTxt->c_str() + 3);
+                }
+            }
+
+            // Note, HTTPS is assumed.  We use the address rather than the .local host name because
+            // a host without avahi-daemon is unlikely to have nss-mdns for curl to resolve it.
+            char buff[512];
+            if(a != nullptr)
+            {
+                snprintf(buff, sizeof(buff), "https://%s:%d/config", a->_rr.address.c_str(), (int)srv->_rr.port);
+            }
+            else
+            {
+                snprintf(buff, sizeof(buff), "https://[%s]:%d/config", aaaa->_rr.address.c_str(), (int)srv->_rr.port);
+            }
+
+            std::string rootUrl(buff);
+
+            ReportedMap_t::iterator itrRep = _reported.find(key);
+            if(itrRep != _reported.end() &&
+               itrRep->second._id == id &&
+               itrRep->second._version == version &&
+               itrRep->second._rootUrl == rootUrl)
+            {
+                continue;
+            }
+
+            if(itrRep == _reported.end())
+            {
+                std::string json;
+
+                json.append("{");
+                    json.append("\"serviceType\":\""); json.append(_configuration.serviceType.c_str()); json.append("\"");
+                    json.append(",\"implementation\":\""); json.append(getImplementation()); json.append("\"");
+                    json.append(",\"name\":\""); json.append(instanceLabel(instance)); json.append("\"");
+                    json.append(",\"hostName\":\""); json.append(srv->_rr.target); json.append("\"");
+                json.append("}");
+
+                if(callFilterHook(json.c_str()) != MAGELLAN_FILTER_PROCEED)
+                {
+                    live.erase(key);
+                    _filtered.insert(key);
+                    continue;
+                }
+
+                Core::getLogger()->i(TAG, "new service instance '%s'", instance.c_str());
+            }
+            else
+            {
+                Core::getLogger()->i(TAG, "service instance changed - '%s'", instance.c_str());
+            }
+
+            ReportedInstance_t ri;
+            ri._id = id;
+            ri._version = version;
+            ri._rootUrl = rootUrl;
+            _reported[key] = ri;
+
+            DataModel::DiscoveredDevice *dd = new DataModel::DiscoveredDevice();
+
+            dd->discovererKey.assign(key);
+            dd->id.assign(id);
+            dd->configVersion = version;
+            dd->rootUrl.assign(rootUrl);
+
+            Core::processDiscoveredDevice(dd);
+        }
+
+        sendQuestions(questions, now);
+
+        // Forget filtering decisions once the instance goes so that a return is re-evaluated
+        for(std::set<std::string>::iterator itr = _filtered.begin();
+            itr != _filtered.end();)
+        {
+            if(present.find(*itr) == present.end())
+            {
+                itr = _filtered.erase(itr);
+            }
+            else
+            {
+                itr++;
+            }
+        }
+
+        // Anything we reported whose PTR has gone (expired or said goodbye) is undiscovered
+        for(ReportedMap_t::iterator itr = _reported.begin();
+            itr != _reported.end();)
+        {
+            if(live.find(itr->first) == live.end())
+            {
+                Core::getLogger()->i(TAG, "'%s' has disappeared", itr->first.c_str());
+                Core::processUndiscoveredDevice(itr->first.c_str());
+                itr = _reported.erase(itr);
+            }
+            else
+            {
+                itr++;
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef MDNSDISCOVERER_HPP
+#define MDNSDISCOVERER_HPP
+
+#include <thread>
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+
+#include "Discoverer.hpp"
+#include "DnsMessage.hpp"
+
+namespace Magellan
+{
+    /** @brief Provides DNS-SD discovery using a built-in mDNS querier (no avahi-daemon/Bonjour required) **/
+    class MdnsDiscoverer : public Discoverer
+    {
+    public:
+        MdnsDiscoverer();
+        virtual ~MdnsDiscoverer();
+
+        // Override from ReferenceCountedObject to stop before deletion
+        virtual void deleteThis();
+
+        virtual bool configure(DataModel::JsonObjectBase& configuration);
+        virtual bool start();
+        virtual void stop();
+        virtual void pause();
+        virtual void resume();
+
+    private:
+        /** @brief A cached resource record **/
+        typedef struct _CacheEntry_t
+        {
+            DnsMessage::Record  _rr;
+            uint64_t            _receivedAt;
+            uint64_t            _expiresAt;
+            int                 _refreshesSent;
+        } CacheEntry_t;
+
+        typedef std::map<std::string, CacheEntry_t> RecordCache_t;
+
+        /** @brief What we last told Core about a service instance **/
+        typedef struct _ReportedInstance_t
+        {
+            std::string         _id;
+            unsigned long       _version;
+            std::string         _rootUrl;
+        } ReportedInstance_t;
+
+        typedef std::map<std::string, ReportedInstance_t> ReportedMap_t;
+
+        DataModel::Mdns                 _configuration;
+        std::atomic<bool>               _running;
+        std::thread                     _workerThreadHandle;
+
+        int                             _sock4;
+        int                             _sock6;
+
+        std::string                     _serviceName;
+        RecordCache_t                   _cache;
+        ReportedMap_t                   _reported;
+        std::set<std::string>           _filtered;
+        std::map<std::string, uint64_t> _lastQueried;
+
+        uint64_t                        _nextQueryAt;
+        uint64_t                        _queryIntervalMs;
+
+        void workerThread();
+
+        bool openSockets();
+        void closeSockets();
+
+        void sendMessage(const DnsMessage& msg);
+        void sendServiceQuery(uint64_t now);
+        void sendQuestions(const std::set<std::pair<std::string, uint16_t>>& questions, uint64_t now);
+
+        void processPacket(const uint8_t *data, size_t len, uint64_t now);
+        void cacheRecord(const DnsMessage::Record& rr, uint64_t now);
+        void expireCache(uint64_t now);
+        void refreshCache(uint64_t now);
+        void evaluateInstances(uint64_t now);
+
+        const CacheEntry_t *findRecord(const std::string& name, uint16_t type);
+        static std::string cacheKey(const DnsMessage::Record& rr);
+        std::string instanceLabel(const std::string& instanceName);
+        std::string makeDiscovererKey(const std::string& instanceName);
+    };
+}
+
+#endif
@@ -0,0 +1,137 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include "ParseArena.hpp"
+
+namespace Magellan
+{
+    static thread_local ParseArena *g_currentArena = nullptr;
+
+    ParseArena::Scope::Scope(ParseArena& arena)
+    {
+        _previous = g_currentArena;
+        g_currentArena = &arena;
+    }
+
+    ParseArena::Scope::~Scope()
+    {
+        g_currentArena = _previous;
+    }
+
+    ParseArena::ParseArena(size_t blockSize, size_t retainBytes)
+    {
+        _blockSize = (blockSize > 0 ? blockSize : 4096);
+        _retainBytes = retainBytes;
+        _current = 0;
+        _used = 0;
+        _inUse = 0;
+        _allocations = 0;
+        _bytes = 0;
+        _peakBytes = 0;
+        _blockAllocations = 0;
+        _resets = 0;
+    }
+
+    ParseArena::~ParseArena()
+    {
+        for(std::vector<Block_t>::iterator itr = _blocks.begin();
+            itr != _blocks.end();
+            itr++)
+        {
+            ::operator delete(itr->_base);
+        }
+    }
+
+    ParseArena *ParseArena::current()
+    {
+        return g_currentArena;
+    }
+
+    void *ParseArena::allocate(size_t size, size_t alignment)
+    {
+        if(size == 0)
+        {
+            size = 1;
+        }
+
+        size_t offset = ((_used + (alignment - 1)) & ~(alignment - 1));
+
+        if(_blocks.empty() || (offset + size) > _blocks[_current]._size)
+        {
+            nextBlock(size);
+            offset = 0;
+        }
+
+        // Blocks come from operator new so their base is suitably aligned for anything
+        void *rc = (_blocks[_current]._base + offset);
+        _inUse += ((offset + size) - _used);
+        _used = (offset + size);
+
+        _allocations++;
+        _bytes += size;
+        if(_inUse > _peakBytes)
+        {
+            _peakBytes = _inUse;
+        }
+
+        return rc;
+    }
+
+    void ParseArena::reset()
+    {
+        // Keep enough blocks that the next pass (probably much like this one) needn't go to the heap
+        size_t kept = 0;
+        size_t retained = 0;
+        while(kept < _blocks.size() && (kept == 0 || (retained + _blocks[kept]._size) <= _retainBytes))
+        {
+            retained += _blocks[kept]._size;
+            kept++;
+        }
+
+        while(_blocks.size() > kept)
+        {
+            ::operator delete(_blocks.back()._base);
+            _blocks.pop_back();
+        }
+
+        _current = 0;
+        _used = 0;
+        _inUse = 0;
+        _resets++;
+    }
+
+    void ParseArena::getStats(Stats_t& stats) const
+    {
+        stats._allocations = _allocations;
+        stats._bytes = _bytes;
+        stats._peakBytes = _peakBytes;
+        stats._blocks = _blockAllocations;
+        stats._resets = _resets;
+    }
+
+    void ParseArena::nextBlock(size_t minimum)
+    {
+        // What was left unused at the end of the block being abandoned is counted as in use
+        if(!_blocks.empty())
+        {
+            _inUse += (_blocks[_current]._size - _used);
+        }
+
+        size_t next = (_blocks.empty() ? 0 : (_current + 1));
+
+        // Reuse a block kept from an earlier pass if it's big enough, otherwise slot a new one in
+        if(next >= _blocks.size() || _blocks[next]._size < minimum)
+        {
+            Block_t b;
+            b._size = (minimum > _blockSize ? minimum : _blockSize);
+            b._base = static_cast<uint8_t*>(::operator new(b._size));
+            _blocks.insert(_blocks.begin() + next, b);
+            _blockAllocations++;
+        }
+
+        _current = next;
+        _used = 0;
+    }
+}
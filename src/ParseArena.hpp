@@ -0,0 +1,171 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef PARSEARENA_HPP
+#define PARSEARENA_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "MagellanDataModel.hpp"
+#include "FlatMap.hpp"
+
+namespace Magellan
+{
+    /**
+     * @brief Monotonic arena for the short-lived objects built while decoding a download
+     *
+     * Allocation just bumps a pointer through large blocks, nothing is freed individually, and reset() releases
+     * everything at once - keeping up to retainBytes of blocks for the next pass so steady-state decoding doesn't
+     * touch the heap for the parse tree at all.  Counters are kept so the allocator traffic saved can be measured.
+     *
+     * Not thread-safe - each arena belongs to one thread at a time (although getStats() may be called from
+     * anywhere).
+     **/
+    class ParseArena
+    {
+    public:
+        /** @brief Counters reported by getStats() **/
+        typedef struct _Stats_t
+        {
+            uint64_t                        _allocations;
+            uint64_t                        _bytes;
+            uint64_t                        _peakBytes;
+            uint64_t                        _blocks;
+            uint64_t                        _resets;
+        } Stats_t;
+
+        /**
+         * @brief Makes an arena the one ArenaAllocator draws from on this thread for as long as the scope exists
+         *
+         * Anything allocated from the arena must be destroyed before the scope ends.
+         **/
+        class Scope
+        {
+        public:
+            explicit Scope(ParseArena& arena);
+            ~Scope();
+
+        private:
+            ParseArena                      *_previous;
+        };
+
+        explicit ParseArena(size_t blockSize = (64 * 1024), size_t retainBytes = (4 * 1024 * 1024));
+        virtual ~ParseArena();
+
+        /** @brief Returns suitably aligned memory valid until the next reset() **/
+        void *allocate(size_t size, size_t alignment);
+
+        /** @brief Releases everything allocated since the last reset **/
+        void reset();
+
+        /** @brief Bytes handed out (including alignment and the ends of outgrown blocks) since the last reset **/
+        inline size_t inUse() const
+        {
+            return _inUse;
+        }
+
+        /** @brief Retrieves the counters (totals across all passes) **/
+        void getStats(Stats_t& stats) const;
+
+        /** @brief The arena in scope on this thread, if any **/
+        static ParseArena *current();
+
+    private:
+        typedef struct _Block_t
+        {
+            uint8_t                         *_base;
+            size_t                          _size;
+        } Block_t;
+
+        std::vector<Block_t>                _blocks;
+        size_t                              _blockSize;
+        size_t                              _retainBytes;
+
+        // Block being allocated from and how much of it is gone
+        size_t                              _current;
+        size_t                              _used;
+        size_t                              _inUse;
+
+        std::atomic<uint64_t>               _allocations;
+        std::atomic<uint64_t>               _bytes;
+        std::atomic<uint64_t>               _peakBytes;
+        std::atomic<uint64_t>               _blockAllocations;
+        std::atomic<uint64_t>               _resets;
+
+        void nextBlock(size_t minimum);
+
+        ParseArena(const ParseArena&);
+        ParseArena& operator=(const ParseArena&);
+    };
+
+    /**
+     * @brief Standard allocator drawing from the ParseArena in scope on the calling thread
+     *
+     * Stateless, as nlohmann::basic_json requires.  With no arena in scope it falls back to the heap.
+     **/
+    template<class T>
+    class ArenaAllocator
+    {
+    public:
+        typedef T value_type;
+
+        ArenaAllocator()
+        {
+        }
+
+        template<class U>
+        ArenaAllocator(const ArenaAllocator<U>&)
+        {
+        }
+
+        T *allocate(size_t n)
+        {
+            ParseArena *arena = ParseArena::current();
+            if(arena != nullptr)
+            {
+                return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+            }
+
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, size_t)
+        {
+            // Arena memory goes back all at once on reset()
+            if(ParseArena::current() == nullptr)
+            {
+                ::operator delete(p);
+            }
+        }
+    };
+
+    template<class T, class U>
+    inline bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&)
+    {
+        return true;
+    }
+
+    template<class T, class U>
+    inline bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&)
+    {
+        return false;
+    }
+
+    /**
+     * @brief JSON document whose nodes, objects and arrays are allocated from the ParseArena in scope
+     *
+     * Objects are FlatMaps - the members of each are held side by side in one allocation and looked up by
+     * scanning.  Strings too long for small-string storage still come from the heap.
+     **/
+    typedef nlohmann::basic_json<FlatMap, std::vector, std::string, bool, std::int64_t, std::uint64_t, double, ArenaAllocator> ArenaJson;
+}
+
+#endif
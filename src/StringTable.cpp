@@ -0,0 +1,166 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include "StringTable.hpp"
+
+namespace Magellan
+{
+    const StringTable::Handle_t StringTable::NONE;
+
+    StringTable::StringTable()
+    {
+        _bytes = 0;
+        _released = 0;
+    }
+
+    StringTable::~StringTable()
+    {
+    }
+
+    StringTable::Handle_t StringTable::intern(const std::string& s)
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        Index_t::iterator itr = _index.find(&s);
+        if(itr != _index.end())
+        {
+            _entries[itr->second - 1]._refs++;
+            return itr->second;
+        }
+
+        Handle_t h;
+        if(!_free.empty())
+        {
+            h = _free.back();
+            _free.pop_back();
+        }
+        else
+        {
+            _entries.push_back(Entry_t());
+            h = (Handle_t)_entries.size();
+        }
+
+        Entry_t& e = _entries[h - 1];
+        e._s = s;
+        e._refs = 1;
+        _bytes += s.size();
+        _index[&e._s] = h;
+
+        return h;
+    }
+
+    void StringTable::addRef(Handle_t h)
+    {
+        if(h == NONE)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lck(_lock);
+
+        _entries[h - 1]._refs++;
+    }
+
+    void StringTable::addRef(const std::vector<Handle_t>& handles)
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        for(std::vector<Handle_t>::const_iterator itr = handles.begin();
+            itr != handles.end();
+            itr++)
+        {
+            if(*itr != NONE)
+            {
+                _entries[*itr - 1]._refs++;
+            }
+        }
+    }
+
+    void StringTable::release(Handle_t h)
+    {
+        if(h == NONE)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lck(_lock);
+
+        releaseLocked(h);
+    }
+
+    void StringTable::release(const std::vector<Handle_t>& handles)
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        for(std::vector<Handle_t>::const_iterator itr = handles.begin();
+            itr != handles.end();
+            itr++)
+        {
+            if(*itr != NONE)
+            {
+                releaseLocked(*itr);
+            }
+        }
+    }
+
+    void StringTable::releaseLocked(Handle_t h)
+    {
+        Entry_t& e = _entries[h - 1];
+
+        if(--e._refs > 0)
+        {
+            return;
+        }
+
+        _index.erase(&e._s);
+        _bytes -= e._s.size();
+        std::string().swap(e._s);
+        _free.push_back(h);
+        _released++;
+    }
+
+    StringTable::Handle_t StringTable::find(const std::string& s) const
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        Index_t::const_iterator itr = _index.find(&s);
+        return (itr != _index.end() ? itr->second : NONE);
+    }
+
+    const std::string& StringTable::get(Handle_t h) const
+    {
+        static const std::string EMPTY;
+
+        std::lock_guard<std::mutex> lck(_lock);
+
+        if(h == NONE || h > _entries.size())
+        {
+            return EMPTY;
+        }
+
+        return _entries[h - 1]._s;
+    }
+
+    size_t StringTable::size() const
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        return (_entries.size() - _free.size());
+    }
+
+    size_t StringTable::bytes() const
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        return _bytes;
+    }
+
+    uint64_t StringTable::released() const
+    {
+        std::lock_guard<std::mutex> lck(_lock);
+
+        return _released;
+    }
+}
@@ -0,0 +1,112 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef STRINGTABLE_HPP
+#define STRINGTABLE_HPP
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Magellan
+{
+    /**
+     * @brief Intern table mapping strings to compact handles
+     *
+     * Each distinct string is held once and is identified by a small integer from then on, so keys that are long
+     * but repeated endlessly (discoverer and device keys) cost four bytes wherever they're kept and compare as
+     * integers.
+     *
+     * Handles are reference counted - intern() and addRef() take a reference, release() gives one back - and a
+     * string goes once the last reference to it does, its handle being reused for a later string.  So the table
+     * only holds what's currently referenced rather than every string ever seen, and a handle must not be used
+     * after its reference has been released.
+     *
+     * Thread-safe.  References returned by get() stay valid for as long as the handle is held.
+     **/
+    class StringTable
+    {
+    public:
+        typedef uint32_t Handle_t;
+
+        /** @brief Never handed out for a string - stands for "none" **/
+        static const Handle_t NONE = 0;
+
+        StringTable();
+        virtual ~StringTable();
+
+        /** @brief Returns the handle for a string with a reference taken on it, adding the string if needed **/
+        Handle_t intern(const std::string& s);
+
+        /** @brief Takes another reference on a handle (NONE is ignored) **/
+        void addRef(Handle_t h);
+
+        /** @brief As above for a number of handles at once **/
+        void addRef(const std::vector<Handle_t>& handles);
+
+        /** @brief Gives back a reference - the string goes with the last one (NONE is ignored) **/
+        void release(Handle_t h);
+
+        /** @brief As above for a number of handles at once **/
+        void release(const std::vector<Handle_t>& handles);
+
+        /** @brief Returns the handle for a string or NONE if it isn't held - no reference is taken **/
+        Handle_t find(const std::string& s) const;
+
+        /** @brief Returns the string for a handle (empty for NONE) **/
+        const std::string& get(Handle_t h) const;
+
+        /** @brief Number of strings held **/
+        size_t size() const;
+
+        /** @brief Number of strings ever released **/
+        uint64_t released() const;
+
+        /** @brief Number of characters held **/
+        size_t bytes() const;
+
+    private:
+        struct Hash
+        {
+            size_t operator()(const std::string *s) const
+            {
+                return std::hash<std::string>()(*s);
+            }
+        };
+
+        struct Equal
+        {
+            bool operator()(const std::string *a, const std::string *b) const
+            {
+                return (*a == *b);
+            }
+        };
+
+        typedef std::unordered_map<const std::string*, Handle_t, Hash, Equal> Index_t;
+
+        typedef struct _Entry_t
+        {
+            std::string                     _s;
+            uint32_t                        _refs;
+        } Entry_t;
+
+        mutable std::mutex                  _lock;
+
+        // A handle is one more than the entry's position - a deque so that strings never move.  Entries whose
+        // strings have gone are reused before the deque grows.
+        std::deque<Entry_t>                 _entries;
+        std::vector<Handle_t>               _free;
+        Index_t                             _index;
+        size_t                              _bytes;
+        uint64_t                            _released;
+
+        void releaseLocked(Handle_t h);
+    };
+}
+
+#endif
@@ -0,0 +1,449 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include <algorithm>
+#include <functional>
+
+#include "TalkgroupRegistry.hpp"
+
+namespace Magellan
+{
+    const size_t TalkgroupRegistry::NO_ROW = (size_t)-1;
+
+    TalkgroupRegistry::TalkgroupRegistry(StringTable& strings)
+    {
+        _strings = &strings;
+        _version = 0;
+        _sequence = 0;
+        _encodedRows = 0;
+    }
+
+    TalkgroupRegistry::TalkgroupRegistry(const TalkgroupRegistry& other)
+        : _strings(other._strings),
+          _version(other._version),
+          _sequence(other._sequence),
+          _devices(other._devices),
+          _rowsById(other._rowsById),
+          _rowsByDevice(other._rowsByDevice),
+          _talkgroups(other._talkgroups),
+          _deviceKeys(other._deviceKeys),
+          _types(other._types),
+          _rxAddresses(other._rxAddresses),
+          _txAddresses(other._txAddresses),
+          _minLevels(other._minLevels),
+          _encoded(other._encoded),
+          _devicePositions(other._devicePositions),
+          _encodedRows(other._encodedRows)
+    {
+        // The copy's strings are as much in use as the original's
+        _strings->addRef(_deviceKeys);
+        _strings->addRef(_rxAddresses);
+        _strings->addRef(_txAddresses);
+    }
+
+    TalkgroupRegistry::~TalkgroupRegistry()
+    {
+        clear();
+    }
+
+    // Takes a reference for a row
+    TalkgroupRegistry::Handle_t TalkgroupRegistry::intern(const std::string& s)
+    {
+        return (s.empty() ? StringTable::NONE : _strings->intern(s));
+    }
+
+    // False if a string isn't held at all - so nothing here can refer to it
+    bool TalkgroupRegistry::lookup(const std::string& s, Handle_t& h) const
+    {
+        h = (s.empty() ? StringTable::NONE : _strings->find(s));
+        return (h != StringTable::NONE || s.empty());
+    }
+
+    size_t TalkgroupRegistry::findRow(const std::string& id, Handle_t deviceKey) const
+    {
+        std::pair<RowIndex_t::const_iterator, RowIndex_t::const_iterator> range = _rowsById.equal_range(id);
+        for(RowIndex_t::const_iterator itr = range.first; itr != range.second; itr++)
+        {
+            if(_deviceKeys[itr->second] == deviceKey)
+            {
+                return itr->second;
+            }
+        }
+
+        return NO_ROW;
+    }
+
+    // The row's device stays the same (rows are found by device) so it only needs a fresh reference
+    void TalkgroupRegistry::setRow(size_t row, const TalkgroupPtr& tg)
+    {
+        // New references are taken before the old ones are let go as the strings are usually the same
+        Handle_t deviceKey = intern(tg->deviceKey());
+        Handle_t rxAddress = StringTable::NONE;
+        Handle_t txAddress = StringTable::NONE;
+
+        _strings->release(_deviceKeys[row]);
+        _encodedRows -= _encoded[row];
+
+        _talkgroups[row] = tg;
+        _deviceKeys[row] = deviceKey;
+
+        // Decoding just to fill the columns would defeat the purpose of leaving it encoded
+        if(!tg->isDecoded())
+        {
+            _types[row] = 0;
+            _minLevels[row] = 0;
+            _encoded[row] = 1;
+            _encodedRows++;
+        }
+        else
+        {
+            LazyTalkgroup::TalkgroupPtr decoded = tg->get();
+            rxAddress = intern(decoded->rx.address);
+            txAddress = intern(decoded->tx.address);
+            _types[row] = decoded->type;
+            _minLevels[row] = decoded->security.minLevel;
+            _encoded[row] = 0;
+        }
+
+        _strings->release(_rxAddresses[row]);
+        _strings->release(_txAddresses[row]);
+        _rxAddresses[row] = rxAddress;
+        _txAddresses[row] = txAddress;
+    }
+
+    void TalkgroupRegistry::appendRow(const TalkgroupPtr& tg)
+    {
+        size_t row = _talkgroups.size();
+
+        _talkgroups.resize(row + 1);
+        _deviceKeys.resize(row + 1, StringTable::NONE);
+        _types.resize(row + 1);
+        _rxAddresses.resize(row + 1, StringTable::NONE);
+        _txAddresses.resize(row + 1, StringTable::NONE);
+        _minLevels.resize(row + 1);
+        _encoded.resize(row + 1, 0);
+        _devicePositions.resize(row + 1);
+
+        setRow(row, tg);
+        _rowsById.insert(std::make_pair(tg->id(), row));
+
+        std::vector<size_t>& deviceRows = _rowsByDevice[_deviceKeys[row]];
+        _devicePositions[row] = deviceRows.size();
+        deviceRows.push_back(row);
+    }
+
+    // The last row moves into the gap so the columns stay dense
+    void TalkgroupRegistry::removeRow(size_t row)
+    {
+        size_t last = (_talkgroups.size() - 1);
+
+        std::pair<RowIndex_t::iterator, RowIndex_t::iterator> range = _rowsById.equal_range(_talkgroups[row]->id());
+        for(RowIndex_t::iterator itr = range.first; itr != range.second; itr++)
+        {
+            if(itr->second == row)
+            {
+                _rowsById.erase(itr);
+                break;
+            }
+        }
+
+        // Out of its device's list the same way
+        DeviceRows_t::iterator itrDevice = _rowsByDevice.find(_deviceKeys[row]);
+        size_t pos = _devicePositions[row];
+        itrDevice->second[pos] = itrDevice->second.back();
+        _devicePositions[itrDevice->second[pos]] = pos;
+        itrDevice->second.pop_back();
+        if(itrDevice->second.empty())
+        {
+            _rowsByDevice.erase(itrDevice);
+        }
+
+        _encodedRows -= _encoded[row];
+
+        _strings->release(_deviceKeys[row]);
+        _strings->release(_rxAddresses[row]);
+        _strings->release(_txAddresses[row]);
+
+        if(row != last)
+        {
+            range = _rowsById.equal_range(_talkgroups[last]->id());
+            for(RowIndex_t::iterator itr = range.first; itr != range.second; itr++)
+            {
+                if(itr->second == last)
+                {
+                    itr->second = row;
+                    break;
+                }
+            }
+
+            _talkgroups[row] = _talkgroups[last];
+            _deviceKeys[row] = _deviceKeys[last];
+            _types[row] = _types[last];
+            _rxAddresses[row] = _rxAddresses[last];
+            _txAddresses[row] = _txAddresses[last];
+            _minLevels[row] = _minLevels[last];
+            _encoded[row] = _encoded[last];
+            _devicePositions[row] = _devicePositions[last];
+            _rowsByDevice[_deviceKeys[row]][_devicePositions[row]] = row;
+        }
+
+        _talkgroups.pop_back();
+        _deviceKeys.pop_back();
+        _types.pop_back();
+        _rxAddresses.pop_back();
+        _txAddresses.pop_back();
+        _minLevels.pop_back();
+        _encoded.pop_back();
+        _devicePositions.pop_back();
+    }
+
+    void TalkgroupRegistry::put(const TalkgroupPtr& tg)
+    {
+        if(!tg || tg->id().empty())
+        {
+            return;
+        }
+
+        // A device that isn't held has no rows yet
+        Handle_t deviceKey;
+        size_t row = (lookup(tg->deviceKey(), deviceKey) ? findRow(tg->id(), deviceKey) : NO_ROW);
+        if(row != NO_ROW)
+        {
+            setRow(row, tg);
+        }
+        else
+        {
+            appendRow(tg);
+        }
+    }
+
+    void TalkgroupRegistry::remove(const std::string& id, const std::string& deviceKey)
+    {
+        // Other devices hosting the talkgroup keep their rows
+        Handle_t h;
+        if(!lookup(deviceKey, h))
+        {
+            return;
+        }
+
+        size_t row = findRow(id, h);
+        if(row != NO_ROW)
+        {
+            removeRow(row);
+        }
+    }
+
+    void TalkgroupRegistry::putDevice(const std::string& deviceKey, const DeviceSummary_t& summary)
+    {
+        _devices[deviceKey] = summary;
+    }
+
+    bool TalkgroupRegistry::holdsDevice(const std::string& deviceKey, const DeviceSummary_t& summary) const
+    {
+        DeviceMap_t::const_iterator itr = _devices.find(deviceKey);
+        if(itr == _devices.end())
+        {
+            return false;
+        }
+
+        const DeviceSummary_t& held = itr->second;
+
+        return (held._url == summary._url &&
+                held._configVersion == summary._configVersion &&
+                held._wireBytes == summary._wireBytes &&
+                held._bodyBytes == summary._bodyBytes &&
+                held._heldBytes == summary._heldBytes &&
+                held._parseBytes == summary._parseBytes &&
+                held._rejectedBodies == summary._rejectedBodies &&
+                held._provisional == summary._provisional);
+    }
+
+    void TalkgroupRegistry::removeDevice(const std::string& deviceKey)
+    {
+        _devices.erase(deviceKey);
+
+        Handle_t h;
+        if(!lookup(deviceKey, h))
+        {
+            return;
+        }
+
+        DeviceRows_t::const_iterator itr = _rowsByDevice.find(h);
+        if(itr == _rowsByDevice.end())
+        {
+            return;
+        }
+
+        // Highest first so that the row moved into each gap is never one of the device's own
+        std::vector<size_t> rows = itr->second;
+        std::sort(rows.begin(), rows.end(), std::greater<size_t>());
+
+        for(std::vector<size_t>::iterator itrRow = rows.begin();
+            itrRow != rows.end();
+            itrRow++)
+        {
+            removeRow(*itrRow);
+        }
+    }
+
+    void TalkgroupRegistry::clear()
+    {
+        _strings->release(_deviceKeys);
+        _strings->release(_rxAddresses);
+        _strings->release(_txAddresses);
+
+        _devices.clear();
+        _rowsById.clear();
+        _rowsByDevice.clear();
+        _talkgroups.clear();
+        _deviceKeys.clear();
+        _types.clear();
+        _rxAddresses.clear();
+        _txAddresses.clear();
+        _minLevels.clear();
+        _encoded.clear();
+        _devicePositions.clear();
+        _encodedRows = 0;
+    }
+
+    TalkgroupRegistry::TalkgroupPtr TalkgroupRegistry::get(const std::string& id) const
+    {
+        RowIndex_t::const_iterator itr = _rowsById.find(id);
+        if(itr != _rowsById.end())
+        {
+            return _talkgroups[itr->second];
+        }
+
+        return TalkgroupPtr();
+    }
+
+    TalkgroupRegistry::TalkgroupPtr TalkgroupRegistry::get(const std::string& id, const std::string& deviceKey) const
+    {
+        Handle_t h;
+        if(!lookup(deviceKey, h))
+        {
+            return TalkgroupPtr();
+        }
+
+        size_t row = findRow(id, h);
+        return (row != NO_ROW ? _talkgroups[row] : TalkgroupPtr());
+    }
+
+    size_t TalkgroupRegistry::size() const
+    {
+        return _talkgroups.size();
+    }
+
+    bool TalkgroupRegistry::rowMatches(size_t row, Handle_t deviceKey, Handle_t address, const DataModel::TalkgroupQuery& q) const
+    {
+        if(deviceKey != StringTable::NONE && _deviceKeys[row] != deviceKey)
+        {
+            return false;
+        }
+
+        if(_encoded[row])
+        {
+            if(q.type < 0 && q.address.empty() && q.securityLevel < 0)
+            {
+                return true;
+            }
+
+            return talkgroupMatches(*_talkgroups[row]->get(), q);
+        }
+
+        if(q.type >= 0 && _types[row] != q.type)
+        {
+            return false;
+        }
+
+        // An address that's never been interned can only be held by talkgroups still encoded
+        if(!q.address.empty() && (address == StringTable::NONE || (_rxAddresses[row] != address && _txAddresses[row] != address)))
+        {
+            return false;
+        }
+
+        if(q.securityLevel >= 0 && _minLevels[row] > q.securityLevel)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TalkgroupRegistry::talkgroupMatches(const DataModel::Talkgroup& tg, const DataModel::TalkgroupQuery& q)
+    {
+        if(q.type >= 0 && tg.type != q.type)
+        {
+            return false;
+        }
+
+        if(!q.address.empty() && tg.rx.address.compare(q.address) != 0 && tg.tx.address.compare(q.address) != 0)
+        {
+            return false;
+        }
+
+        if(q.securityLevel >= 0 && tg.security.minLevel > q.securityLevel)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    void TalkgroupRegistry::query(const DataModel::TalkgroupQuery& q, TalkgroupList_t& results) const
+    {
+        results.clear();
+
+        // Strings are looked up once - one that's never been seen can't match anything
+        Handle_t deviceKey = StringTable::NONE;
+        Handle_t address = StringTable::NONE;
+
+        if(!lookup(q.deviceKey, deviceKey))
+        {
+            return;
+        }
+
+        if(!lookup(q.address, address) && _encodedRows == 0)
+        {
+            return;
+        }
+
+        if(deviceKey == StringTable::NONE && q.address.empty() && q.type < 0 && q.securityLevel < 0)
+        {
+            results = _talkgroups;
+            return;
+        }
+
+        // Only the device's own rows need looking at if there is one
+        if(deviceKey != StringTable::NONE)
+        {
+            DeviceRows_t::const_iterator itr = _rowsByDevice.find(deviceKey);
+            if(itr == _rowsByDevice.end())
+            {
+                return;
+            }
+
+            for(std::vector<size_t>::const_iterator itrRow = itr->second.begin();
+                itrRow != itr->second.end();
+                itrRow++)
+            {
+                if(rowMatches(*itrRow, deviceKey, address, q))
+                {
+                    results.push_back(_talkgroups[*itrRow]);
+                }
+            }
+
+            return;
+        }
+
+        for(size_t row = 0; row < _talkgroups.size(); row++)
+        {
+            if(rowMatches(row, deviceKey, address, q))
+            {
+                results.push_back(_talkgroups[row]);
+            }
+        }
+    }
+}
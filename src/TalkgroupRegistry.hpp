@@ -0,0 +1,167 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef TALKGROUPREGISTRY_HPP
+#define TALKGROUPREGISTRY_HPP
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "MagellanDataModel.hpp"
+#include "LazyTalkgroup.hpp"
+#include "StringTable.hpp"
+
+namespace Magellan
+{
+    /** 
+     * @brief Indexed collection of every talkgroup currently known across all devices
+     * 
+     * Core treats each published registry as an immutable snapshot - changes are made to a copy which then
+     * replaces the published one.  Talkgroups are shared between snapshots so a copy only duplicates the indexes.
+     *
+     * A talkgroup served by several devices (redundant gateways, say) is held once for each of them, stamped with
+     * that device's key, so it stays known for as long as any of them still hosts it.
+     *
+     * The fields queries filter on are held in columns alongside the talkgroups - one row per talkgroup, strings
+     * reduced to handles in the string table the registry was created with - so a query is a linear scan of a few
+     * integer arrays and the talkgroups themselves are only touched for the rows that match.  Each device's rows are
+     * listed as well so that anything to do with a single device only visits its own.  Talkgroups that are still
+     * encoded when they go in only have their device key column filled - filtering them on anything else decodes
+     * them.
+     *
+     * Every registry holds a reference to each string its rows use (copies take their own) so the table keeps a
+     * string for exactly as long as some snapshot still needs it.
+     **/
+    class TalkgroupRegistry
+    {
+    public:
+        typedef LazyTalkgroup::Ptr TalkgroupPtr;
+        typedef std::vector<TalkgroupPtr> TalkgroupList_t;
+
+        /** @brief Summary of a device as at the time of the snapshot **/
+        typedef struct _DeviceSummary_t
+        {
+            std::string         _url;
+            unsigned long       _configVersion;
+            uint64_t            _wireBytes;
+            uint64_t            _bodyBytes;
+            uint64_t            _heldBytes;
+            uint64_t            _parseBytes;
+            uint64_t            _rejectedBodies;
+            bool                _provisional;
+        } DeviceSummary_t;
+
+        typedef std::map<std::string, DeviceSummary_t> DeviceMap_t;
+
+        explicit TalkgroupRegistry(StringTable& strings);
+        TalkgroupRegistry(const TalkgroupRegistry& other);
+        virtual ~TalkgroupRegistry();
+
+        /** @brief Records (or updates) a device **/
+        void putDevice(const std::string& deviceKey, const DeviceSummary_t& summary);
+
+        /** @brief True if the device is held with exactly this summary **/
+        bool holdsDevice(const std::string& deviceKey, const DeviceSummary_t& summary) const;
+
+        /** @brief The devices held **/
+        inline const DeviceMap_t& getDevices() const
+        {
+            return _devices;
+        }
+
+        /** @brief Snapshot version - increases every time a new snapshot is published **/
+        inline uint64_t getVersion() const
+        {
+            return _version;
+        }
+
+        inline void setVersion(uint64_t v)
+        {
+            _version = v;
+        }
+
+        /** @brief Sequence number of the last journaled change reflected in the snapshot **/
+        inline uint64_t getSequence() const
+        {
+            return _sequence;
+        }
+
+        inline void setSequence(uint64_t seq)
+        {
+            _sequence = seq;
+        }
+
+        /** @brief Adds or replaces a talkgroup (keyed by its device key and id) - the talkgroup is shared, not copied **/
+        void put(const TalkgroupPtr& tg);
+
+        /** @brief Removes the talkgroup held on behalf of the given device **/
+        void remove(const std::string& id, const std::string& deviceKey);
+
+        /** @brief Removes a device and all talkgroups it hosts **/
+        void removeDevice(const std::string& deviceKey);
+
+        /** @brief Removes everything **/
+        void clear();
+
+        /** @brief Returns the talkgroup with the given id (from any device hosting it) or an empty pointer **/
+        TalkgroupPtr get(const std::string& id) const;
+
+        /** @brief Returns the talkgroup with the given id as held for the given device or an empty pointer **/
+        TalkgroupPtr get(const std::string& id, const std::string& deviceKey) const;
+
+        /** @brief Returns the talkgroups matching the query **/
+        void query(const DataModel::TalkgroupQuery& q, TalkgroupList_t& results) const;
+
+        /** @brief Number of talkgroups held (counting each device's separately) **/
+        size_t size() const;
+
+    private:
+        typedef StringTable::Handle_t Handle_t;
+        typedef std::unordered_multimap<std::string, size_t> RowIndex_t;
+        typedef std::unordered_map<Handle_t, std::vector<size_t>> DeviceRows_t;
+
+        static const size_t NO_ROW;
+
+        StringTable                                     *_strings;
+        uint64_t                                        _version;
+        uint64_t                                        _sequence;
+        DeviceMap_t                                     _devices;
+        // Rows of each talkgroup id - as many as there are devices hosting it
+        RowIndex_t                                      _rowsById;
+
+        // Rows of each device (in no particular order)
+        DeviceRows_t                                    _rowsByDevice;
+
+        // Row n of each column describes _talkgroups[n]
+        TalkgroupList_t                                 _talkgroups;
+        std::vector<Handle_t>                           _deviceKeys;
+        std::vector<int>                                _types;
+        std::vector<Handle_t>                           _rxAddresses;
+        std::vector<Handle_t>                           _txAddresses;
+        std::vector<int>                                _minLevels;
+        std::vector<uint8_t>                            _encoded;
+
+        // Where each row is in its device's list
+        std::vector<size_t>                             _devicePositions;
+        size_t                                          _encodedRows;
+
+        TalkgroupRegistry& operator=(const TalkgroupRegistry&);
+
+        Handle_t intern(const std::string& s);
+        bool lookup(const std::string& s, Handle_t& h) const;
+        size_t findRow(const std::string& id, Handle_t deviceKey) const;
+        void setRow(size_t row, const TalkgroupPtr& tg);
+        void appendRow(const TalkgroupPtr& tg);
+        void removeRow(size_t row);
+        bool rowMatches(size_t row, Handle_t deviceKey, Handle_t address, const DataModel::TalkgroupQuery& q) const;
+
+        static bool talkgroupMatches(const DataModel::Talkgroup& tg, const DataModel::TalkgroupQuery& q);
+    };
+}
+
+#endif
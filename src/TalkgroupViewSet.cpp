@@ -0,0 +1,116 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#include <string.h>
+
+#include "TalkgroupViewSet.hpp"
+
+namespace Magellan
+{
+    TalkgroupViewSet::TalkgroupViewSet()
+    {
+        clear();
+    }
+
+    TalkgroupViewSet::~TalkgroupViewSet()
+    {
+    }
+
+    void TalkgroupViewSet::clear()
+    {
+        _views.clear();
+        _rallypoints.clear();
+        _arena.clear();
+        memset(&_set, 0, sizeof(_set));
+
+        // Offset 0 is a shared empty string so zero-initialized refs are always valid
+        _arena.push_back(0);
+    }
+
+    MagellanStringRef_t TalkgroupViewSet::store(const std::string& s)
+    {
+        MagellanStringRef_t rc;
+
+        if(s.empty())
+        {
+            rc.offset = 0;
+            rc.length = 0;
+        }
+        else
+        {
+            rc.offset = (uint32_t)_arena.size();
+            rc.length = (uint32_t)s.size();
+            _arena.insert(_arena.end(), s.begin(), s.end());
+            _arena.push_back(0);
+        }
+
+        return rc;
+    }
+
+    void TalkgroupViewSet::add(const DataModel::Talkgroup& tg, uint32_t changeMask)
+    {
+        MagellanTalkgroupView_t v;
+        memset(&v, 0, sizeof(v));
+
+        v.id = store(tg.id);
+        v.deviceKey = store(tg.deviceKey);
+        v.name = store(tg.name);
+        v.cryptoPassword = store(tg.cryptoPassword);
+        v.type = tg.type;
+
+        v.rxAddress = store(tg.rx.address);
+        v.rxPort = tg.rx.port;
+        v.txAddress = store(tg.tx.address);
+        v.txPort = tg.tx.port;
+
+        v.txEncoder = store(tg.txAudio.encoder);
+        v.txFramingMs = tg.txAudio.framingMs;
+        v.txMaxTxSecs = tg.txAudio.maxTxSecs;
+        v.txFdx = (tg.txAudio.fdx ? 1 : 0);
+
+        v.presenceFormat = tg.presence.format;
+        v.presenceIntervalSecs = tg.presence.intervalSecs;
+
+        v.firstRallypoint = (uint32_t)_rallypoints.size();
+        v.rallypointCount = (uint32_t)tg.rallypoints.size();
+        for(std::vector<DataModel::Rallypoint>::const_iterator itr = tg.rallypoints.begin();
+            itr != tg.rallypoints.end();
+            itr++)
+        {
+            MagellanRallypointView_t rp;
+            rp.hostAddress = store(itr->host.address);
+            rp.hostPort = itr->host.port;
+            _rallypoints.push_back(rp);
+        }
+
+        v.changeMask = changeMask;
+
+        _views.push_back(v);
+    }
+
+    void TalkgroupViewSet::addId(const std::string& id)
+    {
+        MagellanTalkgroupView_t v;
+        memset(&v, 0, sizeof(v));
+
+        v.id = store(id);
+        v.firstRallypoint = (uint32_t)_rallypoints.size();
+
+        _views.push_back(v);
+    }
+
+    const MagellanTalkgroupViewSet_t *TalkgroupViewSet::get()
+    {
+        // Pointers are only taken now as the vectors may have reallocated while being filled
+        _set.talkgroups = (_views.empty() ? nullptr : _views.data());
+        _set.talkgroupCount = _views.size();
+        _set.rallypoints = (_rallypoints.empty() ? nullptr : _rallypoints.data());
+        _set.rallypointCount = _rallypoints.size();
+        _set.arena = _arena.data();
+        _set.arenaSize = _arena.size();
+
+        return &_set;
+    }
+}
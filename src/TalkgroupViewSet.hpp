@@ -0,0 +1,51 @@
+//
+//  Copyright (c) 2020 Rally Tactical Systems, Inc.
+//  All rights reserved.
+//
+
+#ifndef TALKGROUPVIEWSET_HPP
+#define TALKGROUPVIEWSET_HPP
+
+#include <string>
+#include <vector>
+
+#include "MagellanTypes.h"
+#include "MagellanDataModel.hpp"
+
+namespace Magellan
+{
+    /** @brief Builds the flat talkgroup views (and their string arena) handed to view callbacks **/
+    class TalkgroupViewSet
+    {
+    public:
+        TalkgroupViewSet();
+        virtual ~TalkgroupViewSet();
+
+        /** @brief Empties the set while keeping its storage for reuse **/
+        void clear();
+
+        /** @brief Adds a full view of a talkgroup **/
+        void add(const DataModel::Talkgroup& tg, uint32_t changeMask = 0);
+
+        /** @brief Adds a view carrying only the talkgroup id (for removals) **/
+        void addId(const std::string& id);
+
+        inline bool empty() const
+        {
+            return _views.empty();
+        }
+
+        /** @brief Returns the C view set - valid until the set is next modified **/
+        const MagellanTalkgroupViewSet_t *get();
+
+    private:
+        std::vector<MagellanTalkgroupView_t>    _views;
+        std::vector<MagellanRallypointView_t>   _rallypoints;
+        std::vector<char>                       _arena;
+        MagellanTalkgroupViewSet_t              _set;
+
+        MagellanStringRef_t store(const std::string& s);
+    };
+}
+
+#endif
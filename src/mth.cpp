@@ -15,15 +15,25 @@
     #include <windows.h>
 #else
     #include <sys/time.h>
+    #include <unistd.h>
 #endif
 #include <math.h>
+#include <inttypes.h>
 #include <chrono>
+#include <map>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "MagellanApi.h"
 #include "MagellanDataModel.hpp"
+#include "ParseArena.hpp"
+#include "FlatMap.hpp"
+#include "ConfigurationScanner.hpp"
+#include "LazyTalkgroup.hpp"
+#include "ConfigurationLimits.hpp"
+#include "ConfigurationCache.hpp"
+#include "MagellanCore.hpp"
 
 const size_t MAX_CMD_BUFF_SIZE = 4096;
 const char *LOG_TAG = "mth";
@@ -36,17 +46,26 @@ int discoveryFilterHook(const char * _Nonnull detailJson, const void * _Nullable
 void onNewTalkgroups(const char * _Nonnull newTalkgroupsJson, const void * _Nullable userData);
 void onModifiedTalkgroups(const char * _Nonnull modifiedTalkgroupsJson, const void * _Nullable userData);
 void onRemovedTalkgroups(const char * _Nonnull removedTalkgroupsJson, const void * _Nullable userData);
+void onTalkgroupViews(const MagellanTalkgroupViewSet_t * _Nonnull viewSet, const void * _Nullable userData);
+void onSubscribedTalkgroups(const char * _Nonnull talkgroupsJson, const void * _Nullable userData);
 
 void showUsage();
 void runTest1();
 void runTest2();
 void runTest3();
 void runTest4();
+bool runTest5();
 std::string loadConfiguration(const char *fn);
 void showTalkgroups();
+void showRegistryTalkgroups();
+void showStats();
+void runParseBenchmark();
 void showHelp();
 
 int m_testLoops = 0;
+int m_test = 3;
+bool m_useViews = false;
+const char *m_subscriptionFilter = nullptr;
 
 int main(int argc, char **argv)
 {
@@ -65,10 +84,22 @@ int main(int argc, char **argv)
         {
             cfgFile = (argv[x] + 5);
         }
+        else if(strncmp(argv[x], "-test:", 6) == 0)
+        {
+            m_test = atoi(argv[x] + 6);
+        }
         else if(strncmp(argv[x], "-tl:", 4) == 0)
         {
             m_testLoops = atoi(argv[x] + 4);
         }
+        else if(strcmp(argv[x], "-views") == 0)
+        {
+            m_useViews = true;
+        }
+        else if(strncmp(argv[x], "-sub:", 5) == 0)
+        {
+            m_subscriptionFilter = (argv[x] + 5);
+        }
         else
         {
             printf("ERROR: unknown option '%s'\n", argv[x]);
@@ -77,6 +108,13 @@ int main(int argc, char **argv)
         }        
     }
 
+    // This one sets the library up itself
+    if(m_test == 5)
+    {
+        magellanSetLoggingHook(&loggingHook);
+        return (runTest5() ? 0 : 1);
+    }
+
     std::string configJson;
     
     if( cfgFile != nullptr)
@@ -103,8 +141,49 @@ int main(int argc, char **argv)
     // Register our talkgroup notification functions
     magellanSetTalkgroupCallbacks(onNewTalkgroups, onModifiedTalkgroups, onRemovedTalkgroups, nullptr);
 
+    if(m_useViews)
+    {
+        magellanSetTalkgroupViewCallbacks(onTalkgroupViews, onTalkgroupViews, onTalkgroupViews, nullptr);
+    }
+
+    MagellanToken_t subscriptionToken = nullptr;
+    if(m_subscriptionFilter != nullptr)
+    {
+        if(magellanSubscribeTalkgroups(m_subscriptionFilter, 
+                                       onSubscribedTalkgroups, 
+                                       onSubscribedTalkgroups, 
+                                       onSubscribedTalkgroups, 
+                                       "subscription", 
+                                       &subscriptionToken) != MAGELLAN_RESULT_OK)
+        {
+            printf("ERROR: invalid subscription filter '%s'\n", m_subscriptionFilter);
+        }
+    }
+
     // Run this test
-    runTest3();    
+    switch(m_test)
+    {
+        case 1:
+            runTest1();
+            break;
+
+        case 2:
+            runTest2();
+            break;
+
+        case 4:
+            runTest4();
+            break;
+
+        default:
+            runTest3();
+            break;
+    }
+
+    if(subscriptionToken != nullptr)
+    {
+        magellanUnsubscribeTalkgroups(subscriptionToken);
+    }
 
     // Shut it down
     magellanShutdown();
@@ -147,7 +226,7 @@ std::string loadConfiguration(const char *fn)
 
 void showUsage()
 {
-    printf("usage: mth [-cfg:configuration_json_file]\n");
+    printf("usage: mth [-cfg:configuration_json_file] [-test:test_number] [-tl:test_loops] [-views] [-sub:subscription_filter_json]\n");
 }
 
 void showHelp()
@@ -159,6 +238,9 @@ void showHelp()
     printf("?      .................... help\n");
     printf("clear  .................... clear the screen\n");
     printf("sg     .................... show talkgroups\n");
+    printf("rg     .................... show talkgroups from the library registry\n");
+    printf("st     .................... show library statistics\n");
+    printf("pb     .................... run the configuration parse benchmark\n");
 
     printf("\n");
 }
@@ -183,6 +265,320 @@ void showTalkgroups()
     printf("\n");
 }
 
+void showRegistryTalkgroups()
+{
+    printf("\n");
+    printf("=====REGISTRY TALKGROUPS=====\n");
+
+    char *json = nullptr;
+    if(magellanQueryTalkgroups(nullptr, &json) == MAGELLAN_RESULT_OK)
+    {
+        nlohmann::json ja = nlohmann::json::parse(json);
+        magellanFreeString(json);
+
+        printf("ID                                                               Name                                                             Device\n");
+        printf("---------------------------------------------------------------- ---------------------------------------------------------------- ------------------------------------------------------------------------\n");
+        for(nlohmann::json::iterator itr = ja.begin();
+            itr != ja.end();
+            itr++)
+        {
+            Magellan::DataModel::Talkgroup tg = *itr;
+            printf("%-64s %-64s %-64s\n", 
+                    tg.id.c_str(),
+                    tg.name.c_str(),
+                    tg.deviceKey.c_str());
+        }
+    }
+    else
+    {
+        printf("ERROR: cannot query the registry\n");
+    }
+
+    printf("\n");
+}
+
+void showStats()
+{
+    printf("\n");
+    printf("=====STATISTICS=====\n");
+
+    char *json = nullptr;
+    if(magellanGetStats(&json) == MAGELLAN_RESULT_OK)
+    {
+        printf("%s\n", nlohmann::json::parse(json).dump(3).c_str());
+        magellanFreeString(json);
+    }
+    else
+    {
+        printf("ERROR: cannot get statistics\n");
+    }
+
+    printf("\n");
+}
+
+// Tallies what JSON documents allocate (other than long strings) so their layouts can be compared
+uint64_t m_domAllocations = 0;
+int64_t m_domLiveBytes = 0;
+
+template<class T>
+class CountingAllocator
+{
+public:
+    typedef T value_type;
+
+    CountingAllocator()
+    {
+    }
+
+    template<class U>
+    CountingAllocator(const CountingAllocator<U>&)
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        m_domAllocations++;
+        m_domLiveBytes += (int64_t)(n * sizeof(T));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        m_domLiveBytes -= (int64_t)(n * sizeof(T));
+        ::operator delete(p);
+    }
+};
+
+template<class T, class U>
+bool operator==(const CountingAllocator<T>&, const CountingAllocator<U>&)
+{
+    return true;
+}
+
+template<class T, class U>
+bool operator!=(const CountingAllocator<T>&, const CountingAllocator<U>&)
+{
+    return false;
+}
+
+typedef nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int64_t, std::uint64_t, double, CountingAllocator> CountedMapJson;
+typedef nlohmann::basic_json<Magellan::FlatMap, std::vector, std::string, bool, std::int64_t, std::uint64_t, double, CountingAllocator> CountedFlatJson;
+
+// Looks up every talkgroup member (and one that's never there) the way the data model does
+template<class J>
+size_t lookupTalkgroupMembers(const J& dom)
+{
+    static const char *MEMBERS[] = {"id", "type", "name", "cryptoPassword", "presence", "rallypoints",
+                                    "rx", "tx", "txAudio", "networkOptions", "security", "unknown"};
+
+    size_t found = 0;
+
+    typename J::const_iterator tgs = dom.find("talkgroups");
+    if(tgs == dom.end())
+    {
+        return 0;
+    }
+
+    for(typename J::const_iterator tg = tgs->begin();
+        tg != tgs->end();
+        tg++)
+    {
+        for(size_t m = 0; m < sizeof(MEMBERS) / sizeof(MEMBERS[0]); m++)
+        {
+            if(tg->find(MEMBERS[m]) != tg->end())
+            {
+                found++;
+            }
+        }
+    }
+
+    return found;
+}
+
+template<class J>
+void benchmarkDom(const char *name, const std::string& text, int iterations)
+{
+    uint64_t allocationsBefore = m_domAllocations;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int x = 0; x < iterations; x++)
+    {
+        J dom = J::parse(text);
+    }
+    double parseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    uint64_t allocations = ((m_domAllocations - allocationsBefore) / iterations);
+
+    int64_t liveBefore = m_domLiveBytes;
+    J dom = J::parse(text);
+    int64_t liveBytes = (m_domLiveBytes - liveBefore);
+
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for(int x = 0; x < iterations; x++)
+    {
+        found += lookupTalkgroupMembers(dom);
+    }
+    double lookupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("    %-8s parse %8.3f ms/iteration, %7" PRIu64 " allocations, %9" PRId64 " bytes held, lookup %8.3f ms/iteration (%zu found)\n",
+            name,
+            parseMs / iterations,
+            allocations,
+            liveBytes,
+            lookupMs / iterations,
+            found / iterations);
+}
+
+void runParseBenchmark()
+{
+    const int TALKGROUP_COUNT = 500;
+    const int ITERATIONS = 50;
+
+    // Sparse is how most gateways publish - only the essentials with everything else left to defaults
+    nlohmann::json sparse;
+    nlohmann::json dense;
+    nlohmann::json sparseTgs = nlohmann::json::array();
+    nlohmann::json denseTgs = nlohmann::json::array();
+
+    for(int x = 0; x < TALKGROUP_COUNT; x++)
+    {
+        char id[64];
+        snprintf(id, sizeof(id), "{tg-%06d}", x);
+
+        nlohmann::json tg;
+        tg["id"] = id;
+        tg["name"] = id;
+        tg["type"] = 1;
+        tg["rx"]["address"] = "239.42.1.1";
+        tg["rx"]["port"] = 49000 + x;
+        sparseTgs.push_back(tg);
+
+        Magellan::DataModel::Talkgroup full = tg;
+        denseTgs.push_back(full);
+    }
+
+    sparse["version"] = 1;
+    sparse["talkgroups"] = sparseTgs;
+    dense["version"] = 1;
+    dense["talkgroups"] = denseTgs;
+
+    const char *names[2] = {"sparse", "dense"};
+    const nlohmann::json *docs[2] = {&sparse, &dense};
+
+    printf("\n");
+    printf("=====PARSE BENCHMARK (%d talkgroups x %d iterations)=====\n", TALKGROUP_COUNT, ITERATIONS);
+
+    for(int d = 0; d < 2; d++)
+    {
+        std::string text = docs[d]->dump();
+
+        // Text to objects
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int x = 0; x < ITERATIONS; x++)
+        {
+            Magellan::DataModel::DeviceConfiguration dc;
+            dc.deserialize(text.c_str());
+        }
+        double parseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // DOM to objects only
+        start = std::chrono::steady_clock::now();
+        for(int x = 0; x < ITERATIONS; x++)
+        {
+            Magellan::DataModel::DeviceConfiguration dc = *docs[d];
+        }
+        double extractMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // Text to objects with the parse tree in an arena - as downloads are decoded
+        Magellan::ParseArena arena;
+        start = std::chrono::steady_clock::now();
+        for(int x = 0; x < ITERATIONS; x++)
+        {
+            Magellan::DataModel::DeviceConfiguration dc;
+            {
+                Magellan::ParseArena::Scope scope(arena);
+                Magellan::ArenaJson dom = Magellan::ArenaJson::parse(text);
+                Magellan::DataModel::fieldsFromJson(dom, dc);
+            }
+            arena.reset();
+        }
+        double arenaMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        Magellan::ParseArena::Stats_t as;
+        arena.getStats(as);
+
+        printf("%-8s %8zu bytes: deserialize %8.3f ms/iteration, extract %8.3f ms/iteration (%.0f talkgroups/sec)\n",
+                names[d],
+                text.size(),
+                parseMs / ITERATIONS,
+                extractMs / ITERATIONS,
+                (extractMs > 0.0 ? ((double)TALKGROUP_COUNT * ITERATIONS * 1000.0) / extractMs : 0.0));
+
+        printf("%-8s %8s        arena %8.3f ms/iteration - %" PRIu64 " allocations/iteration from the arena, %" PRIu64 " heap blocks in all, %" PRIu64 " peak bytes\n",
+                "",
+                "",
+                arenaMs / ITERATIONS,
+                (as._allocations / ITERATIONS),
+                as._blocks,
+                as._peakBytes);
+
+        // Talkgroups only located and hashed - as configurations over the lazy decoding threshold are
+        std::shared_ptr<const std::string> body = std::make_shared<const std::string>(text);
+        size_t located = 0;
+        start = std::chrono::steady_clock::now();
+        for(int x = 0; x < ITERATIONS; x++)
+        {
+            Magellan::ConfigurationScanner scanner;
+            scanner.scan(*body, false);
+
+            std::vector<Magellan::LazyTalkgroup::Ptr> tgs;
+            tgs.reserve(scanner.talkgroups().size());
+            for(size_t t = 0; t < scanner.talkgroups().size(); t++)
+            {
+                const Magellan::ConfigurationScanner::Talkgroup_t& loc = scanner.talkgroups()[t];
+                tgs.push_back(Magellan::LazyTalkgroup::fromEncoding(loc._id, "benchmark", body, loc._offset, loc._length, false));
+            }
+
+            located += tgs.size();
+        }
+        double scanMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        printf("%-8s %8s         lazy %8.3f ms/iteration - %zu talkgroups located, none decoded\n",
+                "",
+                "",
+                scanMs / ITERATIONS,
+                located / ITERATIONS);
+
+        // The pass made over every download before decoding when structural limits are configured
+        Magellan::DataModel::RestLink rl;
+        rl.maxTalkgroups = TALKGROUP_COUNT;
+        rl.maxRallypointsPerTalkgroup = 16;
+        rl.maxStringLength = 4096;
+        Magellan::ConfigurationLimits limits(rl);
+        size_t violations = 0;
+        start = std::chrono::steady_clock::now();
+        for(int x = 0; x < ITERATIONS; x++)
+        {
+            if(limits.check(text, false) != Magellan::ConfigurationLimits::lvNone)
+            {
+                violations++;
+            }
+        }
+        double limitsMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        printf("%-8s %8s       limits %8.3f ms/iteration - %zu violation(s)\n",
+                "",
+                "",
+                limitsMs / ITERATIONS,
+                violations);
+
+        // Object layouts compared - std::map as nlohmann::json uses, and the FlatMap downloads are parsed into
+        benchmarkDom<CountedMapJson>("std::map", text, ITERATIONS);
+        benchmarkDom<CountedFlatJson>("FlatMap", text, ITERATIONS);
+    }
+
+    printf("\n");
+}
+
 void loggingHook(int level, const char * tag, const char *msg)
 {
     #if defined(WIN32)
@@ -363,6 +759,40 @@ void onNewTalkgroups(const char * _Nonnull newTalkgroupsJson, const void * _Null
     }
 }
 
+void onTalkgroupViews(const MagellanTalkgroupViewSet_t * _Nonnull viewSet, const void * _Nullable userData)
+{
+    for(size_t x = 0; x < viewSet->talkgroupCount; x++)
+    {
+        const MagellanTalkgroupView_t *v = &viewSet->talkgroups[x];
+        char buff[1024];
+
+        snprintf(buff, sizeof(buff), "View TG: '%s' - '%s' rx=%s:%d, %u rallypoint(s)",
+                viewSet->arena + v->id.offset,
+                viewSet->arena + v->name.offset,
+                viewSet->arena + v->rxAddress.offset,
+                v->rxPort,
+                v->rallypointCount);
+
+        magellanLogMessage(MAGELLAN_LOG_LEVEL_INFORMATIONAL, LOG_TAG, buff);
+    }
+}
+
+void onSubscribedTalkgroups(const char * _Nonnull talkgroupsJson, const void * _Nullable userData)
+{
+    try
+    {
+        nlohmann::json j = nlohmann::json::parse(talkgroupsJson);
+        char buff[256];
+
+        snprintf(buff, sizeof(buff), "Subscription '%s': %zu talkgroup(s)", (const char*) userData, j.size());
+        magellanLogMessage(MAGELLAN_LOG_LEVEL_INFORMATIONAL, LOG_TAG, buff);
+    }
+    catch(...)
+    {
+        magellanLogMessage(MAGELLAN_LOG_LEVEL_ERROR, LOG_TAG, "cannot parse subscribed talkgroup json");
+    }
+}
+
 void onModifiedTalkgroups(const char * _Nonnull modifiedTalkgroupsJson, const void * _Nullable userData)
 {
     try
@@ -485,6 +915,21 @@ bool processCommandBuffer(char *buff)
         showTalkgroups();
     }    
 
+    else if(strcmp(buff, "rg") == 0)
+    {
+        showRegistryTalkgroups();
+    }    
+
+    else if(strcmp(buff, "st") == 0)
+    {
+        showStats();
+    }    
+
+    else if(strcmp(buff, "pb") == 0)
+    {
+        runParseBenchmark();
+    }    
+
     return true;
 }
 
@@ -630,4 +1075,112 @@ void runTest4()
     }
 
     printf("ended test4\n");
-}
\ No newline at end of file
+}
+
+// Waits a little while for the device to be listed with the given URL
+bool waitForDevice(const char *deviceKey, const char *url, bool provisional)
+{
+    for(int x = 0; x < 50; x++)
+    {
+        char *json = nullptr;
+        if(magellanGetDevices(&json) == MAGELLAN_RESULT_OK)
+        {
+            nlohmann::json j = nlohmann::json::parse(json);
+            magellanFreeString(json);
+
+            for(nlohmann::json::iterator itr = j["devices"].begin(); itr != j["devices"].end(); itr++)
+            {
+                if((*itr)["deviceKey"] == deviceKey && (*itr)["url"] == url && (*itr)["provisional"] == provisional)
+                {
+                    return true;
+                }
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    return false;
+}
+
+// Warm start from the cache followed by rediscovery of the device at a different address - which is where it
+// has to be fetched from from then on
+bool runTest5()
+{
+    printf("starting test5\n");
+
+    const char *DEVICE_KEY = "mth-test5-device";
+    const char *ROUTE_KEY = "mth-test5-route";
+    const char *CACHED_URL = "http://192.0.2.1:8080/magellan";
+    const char *CURRENT_URL = "http://192.0.2.2:8080/magellan";
+
+    #ifndef WIN32
+        char dirTemplate[] = "/tmp/mth-test5-XXXXXX";
+        std::string dir = (mkdtemp(dirTemplate) != nullptr ? dirTemplate : ".");
+    #else
+        std::string dir = ".";
+    #endif
+
+    // The cache as a previous run would have left it
+    {
+        Magellan::ConfigurationCache cache;
+        if(!cache.open(dir))
+        {
+            printf("ERROR: cannot open a cache in '%s'\n", dir.c_str());
+            return false;
+        }
+
+        Magellan::DataModel::DeviceConfiguration dc;
+        Magellan::DataModel::Talkgroup tg;
+        dc.version = 5;
+        tg.id = "mth-test5-talkgroup";
+        tg.name = "Test 5";
+        dc.talkgroups.push_back(tg);
+        cache.store(DEVICE_KEY, CACHED_URL, dc);
+        cache.close();
+    }
+
+    nlohmann::json cfg;
+    cfg["cache"]["directory"] = dir;
+    cfg["cache"]["provisionalAtStartup"] = true;
+    magellanInitialize(cfg.dump().c_str());
+
+    bool passed = waitForDevice(DEVICE_KEY, CACHED_URL, true);
+    if(!passed)
+    {
+        printf("ERROR: cached device was not presented\n");
+    }
+    else
+    {
+        // Rediscovered with the version that's cached so there's nothing to fetch yet
+        Magellan::DataModel::DiscoveredDevice *dd = new Magellan::DataModel::DiscoveredDevice();
+        dd->discovererKey = ROUTE_KEY;
+        dd->id = DEVICE_KEY;
+        dd->rootUrl = CURRENT_URL;
+        dd->configVersion = 5;
+        Magellan::Core::processDiscoveredDevice(dd);
+
+        passed = waitForDevice(DEVICE_KEY, CURRENT_URL, false);
+        if(!passed)
+        {
+            printf("ERROR: rediscovered device is not using %s\n", CURRENT_URL);
+        }
+
+        Magellan::Core::processUndiscoveredDevice(ROUTE_KEY);
+    }
+
+    magellanShutdown();
+
+    std::string fn = dir + "/" + Magellan::ConfigurationCache::FILE_NAME;
+    remove(fn.c_str());
+    #ifndef WIN32
+        if(dir != ".")
+        {
+            rmdir(dir.c_str());
+        }
+    #endif
+
+    printf("ended test5 - %s\n", (passed ? "passed" : "FAILED"));
+
+    return passed;
+}